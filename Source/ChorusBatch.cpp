@@ -0,0 +1,220 @@
+#include "ChorusBatch.h"
+#include "SimdVec.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr double twoPi = 6.283185307179586476925286766559;
+}
+
+void ChorusBatch::prepare (double sampleRate, int newNumInstances, int maxBlockSize)
+{
+    release();
+
+    currentSampleRate = sampleRate;
+    numInstances = std::max (newNumInstances, 1);
+    numGroups = (numInstances + lanesPerGroup - 1) / lanesPerGroup;
+    maxChunk = std::max (maxBlockSize, 1);
+
+    const auto numLanes = static_cast<size_t> (numGroups * lanesPerGroup);
+    phase.assign (numLanes, 0.0);
+    phaseIncrement.assign (numLanes, 0.0);
+    cosIncrement.assign (numLanes, 1.0f);
+    sinIncrement.assign (numLanes, 0.0f);
+    lfoSmoothed.assign (numLanes, 0.5f);
+    depthCurve.assign (numLanes, 0.0f);
+    wetGain.assign (numLanes, 0.0f);
+    dryGain.assign (numLanes, 1.0f);
+
+    // Mismo buffer de 35ms que ChorusEngine, 8 carriles por grupo
+    const int delayFrames = std::max (static_cast<int> (sampleRate * 0.035), 1024);
+    const size_t delayFloats = DelayLine::getRequiredFloats (delayFrames, lanesPerGroup, numGroups);
+    arena.reserve (DspArena::bytesFor<float> (delayFloats));
+    arena.rewind();
+    delayLine.prepare (delayFrames, lanesPerGroup, numGroups, arena.allocate<float> (delayFloats));
+    frameBuffer.assign (static_cast<size_t> (maxChunk * lanesPerGroup), 0.0f);
+
+    for (int i = 0; i < numInstances; ++i)
+        setParameters (i, {});
+
+    writePosition = 0;
+    prepared = true;
+}
+
+void ChorusBatch::reset()
+{
+    delayLine.clear();
+    std::fill (phase.begin(), phase.end(), 0.0);
+    std::fill (lfoSmoothed.begin(), lfoSmoothed.end(), 0.5f);
+    writePosition = 0;
+}
+
+void ChorusBatch::release()
+{
+    delayLine.release();
+    phase.clear();
+    phaseIncrement.clear();
+    cosIncrement.clear();
+    sinIncrement.clear();
+    lfoSmoothed.clear();
+    depthCurve.clear();
+    wetGain.clear();
+    dryGain.clear();
+    frameBuffer.clear();
+    numGroups = 0;
+    prepared = false;
+}
+
+void ChorusBatch::setParameters (int instance, const ChorusEngine::Parameters& p)
+{
+    if (instance < 0 || instance >= numInstances)
+        return;
+
+    const auto i = static_cast<size_t> (instance);
+    phaseIncrement[i] = p.rate / currentSampleRate;
+    cosIncrement[i] = static_cast<float> (std::cos (twoPi * phaseIncrement[i]));
+    sinIncrement[i] = static_cast<float> (std::sin (twoPi * phaseIncrement[i]));
+
+    // Mismas constantes de bloque que ChorusEngine
+    float adaptiveSmoothing = 1.0f;
+    if (p.depth > 0.3f)
+        adaptiveSmoothing = 1.0f - ((p.depth - 0.3f) / 0.7f) * 0.2f;
+
+    depthCurve[i] = p.depth * p.depth;
+    wetGain[i] = p.mix * 0.95f * adaptiveSmoothing;
+    dryGain[i] = 1.0f - p.mix;
+}
+
+void ChorusBatch::process (float* const* instanceBuffers, int numSamples)
+{
+    if (! prepared)
+        return;
+
+    ScopedFlushDenormals noDenormals;
+
+    for (int offset = 0; offset < numSamples; offset += maxChunk)
+    {
+        const int chunkSize = std::min (maxChunk, numSamples - offset);
+
+        for (int g = 0; g < numGroups; ++g)
+            processGroup<Float8> (g, instanceBuffers, offset, chunkSize);
+
+        writePosition = (writePosition + chunkSize) & delayLine.getMask();
+    }
+}
+
+template <typename Vec>
+void ChorusBatch::processGroup (int group, float* const* instanceBuffers, int offset, int numSamples)
+{
+    constexpr int W = Vec::width;
+    static_assert (W == lanesPerGroup, "one instance per lane");
+
+    const int firstInstance = group * W;
+    const int groupInstances = std::min (W, numInstances - firstInstance);
+    const int mask = delayLine.getMask();
+    const auto lane0 = static_cast<size_t> (firstInstance);
+
+    // Entrada planar -> frames intercalados
+    float* frames = frameBuffer.data();
+    for (int i = 0; i < numSamples; ++i)
+        for (int lane = 0; lane < W; ++lane)
+            frames[i * W + lane] = lane < groupInstances ? instanceBuffers[firstInstance + lane][offset + i] : 0.0f;
+
+    // LFO de cada carril: sin/cos al inicio del bloque, luego rotacion por frame
+    alignas (32) float s0[W], c0[W];
+    for (int lane = 0; lane < W; ++lane)
+    {
+        const double p = phase[lane0 + (size_t) lane] + phaseIncrement[lane0 + (size_t) lane];
+        s0[lane] = static_cast<float> (std::sin (twoPi * p));
+        c0[lane] = static_cast<float> (std::cos (twoPi * p));
+    }
+
+    auto s = Vec::load (s0);
+    auto c = Vec::load (c0);
+    auto smoothed = Vec::load (lfoSmoothed.data() + lane0);
+
+    const auto cosInc = Vec::load (cosIncrement.data() + lane0);
+    const auto sinInc = Vec::load (sinIncrement.data() + lane0);
+    const auto depthCurves = Vec::load (depthCurve.data() + lane0);
+    const auto wet = Vec::load (wetGain.data() + lane0);
+    const auto dry = Vec::load (dryGain.data() + lane0);
+
+    const auto half = Vec::broadcast (0.5f);
+    const auto one = Vec::broadcast (1.0f);
+    const auto smoothCoeff = Vec::broadcast (0.9995f);
+    const auto inputCoeff = Vec::broadcast (0.0005f);
+    const auto baseDelayMs = Vec::broadcast (15.0f);
+    const auto depthRangeMs = Vec::broadcast (7.0f);
+    const auto sampleRate = Vec::broadcast (static_cast<float> (currentSampleRate));
+    const auto msPerSecond = Vec::broadcast (1000.0f);
+    const auto minDelay = Vec::broadcast (10.0f);
+    const auto maxDelay = Vec::broadcast (static_cast<float> (delayLine.getCapacity() - 10));
+    const auto inputGain = Vec::broadcast (0.999f);
+    const auto threshold = Vec::broadcast (0.99f);
+    const auto negThreshold = Vec::broadcast (-0.99f);
+    const auto kneeSlope = Vec::broadcast (0.3f);
+
+    float* delayData = delayLine.getGroup (group);
+    alignas (32) int delayCeil[W];
+    alignas (32) int offsets[W];
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const int writePos = (writePosition + i) & mask;
+        const auto input = Vec::load (frames + i * W);
+
+        delayLine.write (delayData, writePos, input * inputGain);
+
+        // LFO suavizado por carril
+        smoothed = smoothCoeff * smoothed + inputCoeff * (half + half * s);
+        const auto nextS = s * cosInc + c * sinInc;
+        c = c * cosInc - s * sinInc;
+        s = nextS;
+
+        const auto delayTimeMs = baseDelayMs + depthRangeMs * (depthCurves * smoothed);
+        const auto delayTimeSamples = Vec::min (Vec::max (delayTimeMs * sampleRate / msPerSecond, minDelay), maxDelay);
+        const auto ceilDelay = Vec::truncate (delayTimeSamples) + one;
+        const auto frac = ceilDelay - delayTimeSamples;
+        ceilDelay.storeTruncated (delayCeil);
+
+        // Cada carril lee su propia ventana: gather de 4 frames contiguos
+        for (int lane = 0; lane < W; ++lane)
+            offsets[lane] = ((writePos - delayCeil[lane] - 1) & mask) * W + lane;
+
+        const auto y0 = Vec::gather (delayData, offsets);
+        const auto y1 = Vec::gather (delayData + W, offsets);
+        const auto y2 = Vec::gather (delayData + 2 * W, offsets);
+        const auto y3 = Vec::gather (delayData + 3 * W, offsets);
+
+        // Pesos Catmull-Rom
+        const auto t2 = frac * frac;
+        const auto t3 = t2 * frac;
+        const auto delayed = y0 * (t2 - half * frac - half * t3)
+                           + y1 * (one - Vec::broadcast (2.5f) * t2 + Vec::broadcast (1.5f) * t3)
+                           + y2 * (half * frac + Vec::broadcast (2.0f) * t2 - Vec::broadcast (1.5f) * t3)
+                           + y3 * (half * t3 - half * t2);
+
+        auto output = input * dry + delayed * wet;
+
+        output = Vec::select (Vec::greaterThan (output, threshold), threshold + (output - threshold) * kneeSlope,
+                 Vec::select (Vec::lessThan (output, negThreshold), negThreshold + (output - negThreshold) * kneeSlope,
+                              output));
+
+        output.store (frames + i * W);
+    }
+
+    smoothed.store (lfoSmoothed.data() + lane0);
+
+    for (int lane = 0; lane < W; ++lane)
+    {
+        auto& p = phase[lane0 + (size_t) lane];
+        p += phaseIncrement[lane0 + (size_t) lane] * numSamples;
+        p -= std::floor (p);
+    }
+
+    // Frames intercalados -> salida planar
+    for (int i = 0; i < numSamples; ++i)
+        for (int lane = 0; lane < groupInstances; ++lane)
+            instanceBuffers[firstInstance + lane][offset + i] = frames[i * W + lane];
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "ChorusEngine.h"
+#include "DelayLine.h"
+#include "DspArena.h"
+#include <vector>
+
+// Muchas instancias independientes de Koruz en una sola pasada SIMD.
+// Cada carril de Float8 es una instancia mono (un canal de una pista; una pista
+// stereo ocupa dos carriles) con su propio rate/depth/mix, LFO y delay line.
+// El estado va en structure-of-arrays: 8 instancias por registro.
+// Para el renderer offline y wrappers multipista del host; no usa voces.
+class ChorusBatch
+{
+public:
+    static constexpr int lanesPerGroup = 8;
+
+    void prepare (double sampleRate, int numInstances, int maxBlockSize);
+    void reset();
+    void release();
+
+    void setParameters (int instance, const ChorusEngine::Parameters& newParameters);
+
+    // instanceBuffers[i] es el buffer mono de la instancia i, procesado in-place
+    void process (float* const* instanceBuffers, int numSamples);
+
+    int getNumInstances() const { return numInstances; }
+    bool isPrepared() const { return prepared; }
+
+private:
+    template <typename Vec>
+    void processGroup (int group, float* const* instanceBuffers, int offset, int numSamples);
+
+    double currentSampleRate = 44100.0;
+    int numInstances = 0;
+    int numGroups = 0;
+    int maxChunk = 0;
+
+    // Estado por carril (SoA), numGroups * lanesPerGroup entradas
+    std::vector<double> phase;
+    std::vector<double> phaseIncrement;
+    std::vector<float> cosIncrement;
+    std::vector<float> sinIncrement;
+    std::vector<float> lfoSmoothed;
+    std::vector<float> depthCurve;
+    std::vector<float> wetGain;
+    std::vector<float> dryGain;
+
+    DspArena arena;   // memoria del delay line, se reutiliza entre prepare
+    DelayLine delayLine;
+    int writePosition = 0;
+
+    std::vector<float> frameBuffer;
+    bool prepared = false;
+};
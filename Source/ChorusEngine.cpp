@@ -0,0 +1,881 @@
+#include "ChorusEngine.h"
+#include "Interpolators.h"
+#include "KoruzTrace.h"
+#include "SimdVec.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    int getLaneWidth (int numChannels)  { return numChannels <= Float4::width ? Float4::width : Float8::width; }
+    int getNumGroups (int numChannels)  { return (numChannels + getLaneWidth (numChannels) - 1) / getLaneWidth (numChannels); }
+
+    // Buffer de delay (35ms), redondeado a potencia de dos en DelayLine
+    int getDelayFrames (double sampleRate) { return std::max (static_cast<int> (sampleRate * 0.035), 1024); }
+
+    // Entrada planar -> frames intercalados de un grupo (carriles sobrantes a cero)
+    template <typename SampleType>
+    void interleave (SampleType* const* channels, int firstChannel, int groupChannels, int offset, int numSamples, float* frames, int laneWidth)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            float* frame = frames + i * laneWidth;
+            for (int lane = 0; lane < laneWidth; ++lane)
+                frame[lane] = lane < groupChannels ? static_cast<float> (channels[firstChannel + lane][offset + i]) : 0.0f;
+        }
+    }
+
+    // Frames intercalados -> salida planar
+    template <typename SampleType>
+    void deinterleave (const float* frames, int laneWidth, SampleType* const* channels, int firstChannel, int groupChannels, int offset, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float* frame = frames + i * laneWidth;
+            for (int lane = 0; lane < groupChannels; ++lane)
+                channels[firstChannel + lane][offset + i] = static_cast<SampleType> (frame[lane]);
+        }
+    }
+
+    // Taps de cada carril en un delay line planar, traspuestos a un vector por tap
+    // (taps[k] = tap k de todos los carriles): una carga contigua por carril y una
+    // trasposicion 4x4 por cada 4 carriles y 4 taps
+    template <int numTaps>
+    KORUZ_INLINE void loadQuadTaps (const float* lanes, size_t laneStride, const int* positions, Float4* taps)
+    {
+        static_assert (numTaps <= DelayLine::guardFrames, "window must fit in the guard frames");
+
+        for (int first = 0; first < numTaps; first += 4)
+        {
+            auto a = Float4::load (lanes + positions[0] + first);
+            auto b = Float4::load (lanes + laneStride + positions[1] + first);
+            auto c = Float4::load (lanes + 2 * laneStride + positions[2] + first);
+            auto d = Float4::load (lanes + 3 * laneStride + positions[3] + first);
+            Float4::transpose (a, b, c, d);
+
+            const Float4 columns[4] = { a, b, c, d };
+            for (int k = 0; k < 4 && first + k < numTaps; ++k)
+                taps[first + k] = columns[k];
+        }
+    }
+
+    template <int numTaps, typename Vec>
+    KORUZ_INLINE void loadLaneTaps (const float* group, size_t laneStride, const int* positions, Vec* taps)
+    {
+        if constexpr (Vec::width == Float4::width)
+        {
+            loadQuadTaps<numTaps> (group, laneStride, positions, taps);
+        }
+        else
+        {
+            Float4 low[numTaps], high[numTaps];
+            loadQuadTaps<numTaps> (group, laneStride, positions, low);
+            loadQuadTaps<numTaps> (group + 4 * laneStride, laneStride, positions + 4, high);
+
+            for (int k = 0; k < numTaps; ++k)
+                taps[k] = Vec::combine (low[k], high[k]);
+        }
+    }
+}
+
+size_t ChorusEngine::getRequiredBytes (double sampleRate, int numChannels)
+{
+    numChannels = std::min (std::max (numChannels, 1), maxChannels);
+    const int lanes = getLaneWidth (numChannels);
+    const int groups = getNumGroups (numChannels);
+
+    // Mismo reparto que prepare
+    return DspArena::bytesFor<float> (DelayLine::getRequiredFloats (getDelayFrames (sampleRate), lanes, groups))
+         + DspArena::bytesFor<float> (static_cast<size_t> (groups * maxVoices * lanes)) // allpassState
+         + DspArena::bytesFor<float> (OversampledClipper::getRequiredFloats (numChannels))
+         + ChorusWorkspace::getRequiredBytes (fallbackChunkFrames);
+}
+
+ChorusEngine::MemoryUsage ChorusEngine::getMemoryUsage() const
+{
+    MemoryUsage usage;
+    usage.instanceBytes = sizeof (ChorusEngine) + arena.getCapacity();
+    usage.sharedBytes = ChorusWorkspacePool::getSharedBytes();
+    usage.sharingEngines = ChorusWorkspacePool::getNumUsers();
+    return usage;
+}
+
+void ChorusEngine::reserve (double maxSampleRate, int maxNumChannels)
+{
+    release();
+    arena.reserve (getRequiredBytes (maxSampleRate, maxNumChannels));
+}
+
+void ChorusEngine::prepare (double sampleRate, int newNumChannels, int maxBlockSize)
+{
+    KORUZ_TRACE_SCOPE (traceRing, "engine prepare");
+
+    release();
+
+    currentSampleRate = sampleRate;
+    numChannels = std::min (std::max (newNumChannels, 1), maxChannels);
+    laneWidth = getLaneWidth (numChannels);
+    numGroups = getNumGroups (numChannels);
+    maxChunk = std::min (std::max (maxBlockSize, 1), maxChunkFrames);
+
+    // MEMORIA - solo se reserva si la configuracion no cabe en lo ya reservado;
+    // todo lo repartido sale a cero. La de trabajo compartida se toma con el
+    // primer prepare y se conserva hasta destruir el motor
+    arena.reserve (getRequiredBytes (sampleRate, numChannels));
+    arena.rewind();
+
+    if (workspacePool == nullptr)
+        workspacePool = ChorusWorkspacePool::acquire();
+
+    const int delayFrames = getDelayFrames (sampleRate);
+    delayLine.prepare (delayFrames, laneWidth, numGroups,
+                       arena.allocate<float> (DelayLine::getRequiredFloats (delayFrames, laneWidth, numGroups)),
+                       decorrelated);
+
+    allpassStateSize = static_cast<size_t> (numGroups * maxVoices * laneWidth);
+    allpassState = arena.allocate<float> (allpassStateSize);
+    clipper.prepare (numChannels, arena.allocate<float> (OversampledClipper::getRequiredFloats (numChannels)));
+    ownWorkspace.allocate (arena, fallbackChunkFrames);
+
+    // Frames de silencio necesarios para que ninguna voz lea ya senal
+    const int maxDelayFrames = static_cast<int> (std::ceil (sampleRate * maxDelaySeconds)) + DelayLine::guardFrames;
+    drainFrames = std::max (static_cast<int> (std::ceil (sampleRate * tailSeconds)), maxDelayFrames);
+    silentFrames = 0;
+    idle = false;
+
+    // Tras prepare se arranca en los valores actuales, sin rampa ni fundido
+    if (switchPending)
+        applyStructure (pendingVoices, pendingInterpolation);
+
+    const int rampLength = std::max (static_cast<int> (sampleRate * rampTimeSeconds), 1);
+    rateRamp.reset (params.rate, rampLength);
+    depthRamp.reset (params.depth, rampLength);
+    mixRamp.reset (params.mix, rampLength);
+    switchRamp.reset (1.0f, std::max (static_cast<int> (sampleRate * switchFadeSeconds), 1));
+    switchPending = false;
+
+    lfo.prepare (sampleRate);
+    lfo.setRate (params.rate);
+    setParameters (params);
+
+    writePosition = 0;
+    prepared = true;
+}
+
+void ChorusEngine::reset()
+{
+    delayLine.clear();
+    std::fill (allpassState, allpassState + allpassStateSize, 0.0f);
+    clipper.clear();
+    writePosition = 0;
+    silentFrames = 0;
+    idle = false;
+    lfo.reset();
+}
+
+void ChorusEngine::release()
+{
+    delayLine.release();
+    allpassState = nullptr;
+    allpassStateSize = 0;
+    ownWorkspace = {};
+    useWorkspace (ownWorkspace);
+    clipper.release();
+    numGroups = 0;
+    prepared = false;
+}
+
+void ChorusEngine::setParameters (const Parameters& newParameters)
+{
+    const int voices = std::min (std::max (newParameters.voices, 1), maxVoices);
+    const auto interpolation = newParameters.interpolation;
+
+    params.rate = newParameters.rate;
+    params.depth = newParameters.depth;
+    params.mix = newParameters.mix;
+
+    rateRamp.setTarget (params.rate);
+    depthRamp.setTarget (params.depth);
+    mixRamp.setTarget (params.mix);
+
+    // Sin audio en marcha la estructura cambia directamente
+    if (! prepared)
+    {
+        applyStructure (voices, interpolation);
+        return;
+    }
+
+    if (voices != params.voices || interpolation != params.interpolation)
+    {
+        pendingVoices = voices;
+        pendingInterpolation = interpolation;
+        switchPending = true;
+        switchRamp.setTarget (0.0f);
+    }
+    else if (switchPending)
+    {
+        // Se ha vuelto a la estructura actual antes de llegar a cero
+        switchPending = false;
+        switchRamp.setTarget (1.0f);
+    }
+}
+
+void ChorusEngine::setChannelPhaseOffsets (const float* cycles, int count)
+{
+    decorrelated = false;
+
+    for (int ch = 0; ch < maxChannels; ++ch)
+    {
+        const float offset = ch < count ? cycles[ch] - std::floor (cycles[ch]) : 0.0f;
+        channelPhase[ch] = offset;
+        decorrelated = decorrelated || offset != 0.0f;
+    }
+
+    // Mismo tamano en los dos layouts: se cambia sin reservar, vaciando el delay line
+    if (prepared && decorrelated != delayLine.isPlanar())
+    {
+        delayLine.setPlanar (decorrelated);
+        std::fill (allpassState, allpassState + allpassStateSize, 0.0f);
+    }
+
+    updateLanePhases();
+}
+
+float ChorusEngine::getLayoutPhaseOffset (int channel, int numChannels)
+{
+    if (numChannels <= 2)
+        return 0.0f;
+
+    const double offset = channel * 0.6180339887498949;
+    return static_cast<float> (offset - std::floor (offset));
+}
+
+void ChorusEngine::setClipOversampling (bool shouldOversample)
+{
+    clipOversampling = shouldOversample;
+    kernelClipLevel = clipOversampling ? std::numeric_limits<float>::max() : OversampledClipper::threshold;
+    clipper.clear();
+}
+
+void ChorusEngine::updateLanePhases()
+{
+    if (! decorrelated)
+        return;
+
+    // Voces repartidas uniformemente y cada canal desplazado sobre ellas
+    for (int v = 0; v < maxVoices; ++v)
+        for (int ch = 0; ch < maxChannels; ++ch)
+        {
+            const double offset = 6.283185307179586 * (static_cast<double> (v) / params.voices + channelPhase[ch]);
+            laneCos[v * maxChannels + ch] = v < params.voices ? static_cast<float> (std::cos (offset)) : 0.0f;
+            laneSin[v * maxChannels + ch] = v < params.voices ? static_cast<float> (std::sin (offset)) : 0.0f;
+        }
+}
+
+void ChorusEngine::applyStructure (int voices, Interpolation interpolation)
+{
+    KORUZ_TRACE_SCOPE (traceRing, "structure switch");
+
+    // El allpass arranca sin historia al activarlo
+    if (interpolation == Interpolation::allpass && params.interpolation != Interpolation::allpass)
+        std::fill (allpassState, allpassState + allpassStateSize, 0.0f);
+
+    params.interpolation = interpolation;
+
+    if (voices != params.voices || voiceCos[0] != 1.0f)
+    {
+        params.voices = voices;
+
+        // Voces repartidas uniformemente en fase
+        for (int v = 0; v < maxVoices; ++v)
+        {
+            const double offset = 6.283185307179586 * v / params.voices;
+            voiceCos[v] = v < params.voices ? static_cast<float> (std::cos (offset)) : 0.0f;
+            voiceSin[v] = v < params.voices ? static_cast<float> (std::sin (offset)) : 0.0f;
+        }
+
+        updateLanePhases();
+    }
+}
+
+void ChorusEngine::useWorkspace (const ChorusWorkspace& workspace)
+{
+    lfoSin = workspace.lfoSin;
+    lfoCos = workspace.lfoCos;
+    tapIndices = workspace.tapIndices;
+    tapWeights = workspace.tapWeights;
+    depthValues = workspace.depthValues;
+    wetGains = workspace.wetGains;
+    dryGains = workspace.dryGains;
+    frameBuffer = workspace.frameBuffer;
+    clipScratch = workspace.clipScratch;
+    chunkFrames = std::min (maxChunk, workspace.chunkFrames);
+}
+
+template <typename SampleType>
+void ChorusEngine::process (SampleType* const* channels, int numChannelsToProcess, int numSamples)
+{
+    if (! prepared)
+        return;
+
+    // MEMORIA DE TRABAJO - un hueco del pool mientras dura el bloque; con todos
+    // ocupados, la propia en tramos mas cortos
+    const int slot = workspacePool->tryLock (lastWorkspaceSlot);
+    if (slot >= 0)
+        lastWorkspaceSlot = slot;
+
+    useWorkspace (slot >= 0 ? workspacePool->getWorkspace (slot) : ownWorkspace);
+
+    processBlock (channels, std::min (numChannelsToProcess, numChannels), numSamples);
+
+    if (slot >= 0)
+        workspacePool->unlock (slot);
+}
+
+template <typename SampleType>
+void ChorusEngine::processBlock (SampleType* const* channels, int numChannelsToProcess, int numSamples)
+{
+    // SILENCIO - tras vaciar el delay line no hay nada que interpolar
+    if (isSilent (channels, numChannelsToProcess, numSamples))
+    {
+        idle = silentFrames >= drainFrames;
+        silentFrames = std::min (silentFrames + numSamples, drainFrames);
+
+        if (idle)
+        {
+            // Sin wet audible no hace falta fundido
+            if (switchPending)
+            {
+                applyStructure (pendingVoices, pendingInterpolation);
+                switchPending = false;
+            }
+
+            switchRamp.reset (1.0f, std::max (static_cast<int> (currentSampleRate * switchFadeSeconds), 1));
+            processIdle (channels, numChannelsToProcess, numSamples);
+
+            // Con el sobremuestreo vacio y el bloque a cero la rodilla no cambia nada
+            if (clipOversampling && ! clipper.isPassThrough (channels, numChannelsToProcess, numSamples))
+                processClipper (channels, numChannelsToProcess, numSamples);
+
+            ++skippedBlocks;
+            return;
+        }
+    }
+    else
+    {
+        silentFrames = 0;
+        idle = false;
+    }
+
+    // FUNDIDO DE ESTRUCTURA - los tramos se cortan donde el wet llega a cero
+    for (int offset = 0; offset < numSamples;)
+    {
+        if (switchPending && ! switchRamp.isRamping())
+        {
+            applyStructure (pendingVoices, pendingInterpolation);
+            switchPending = false;
+            switchRamp.setTarget (1.0f);
+        }
+
+        int segment = numSamples - offset;
+        if (switchPending)
+            segment = std::min (segment, switchRamp.getRemaining());
+
+        processSegment (channels, numChannelsToProcess, offset, segment);
+        offset += segment;
+    }
+
+    processClipper (channels, numChannelsToProcess, numSamples);
+}
+
+template <typename SampleType>
+void ChorusEngine::processClipper (SampleType* const* channels, int numChannelsToProcess, int numSamples)
+{
+    // PROTECCIÓN CONTRA CLIPPING a 2x; sin el, la rodilla ya va en el bucle.
+    // En reposo tambien pasa: la latencia no puede cambiar
+    if (! clipOversampling)
+        return;
+
+    KORUZ_TRACE_SCOPE (traceRing, "oversampled clip");
+    clipper.process (channels, numChannelsToProcess, numSamples, clipScratch, chunkFrames);
+}
+
+template <typename SampleType>
+void ChorusEngine::processSegment (SampleType* const* channels, int numChannelsToProcess, int offset, int numSamples)
+{
+    // INTERPOLACIÓN - un kernel completo por politica
+    switch (params.interpolation)
+    {
+        case Interpolation::linear:     processChunks<LinearInterpolator> (channels, numChannelsToProcess, offset, numSamples); break;
+        case Interpolation::lagrange:   processChunks<LagrangeInterpolator> (channels, numChannelsToProcess, offset, numSamples); break;
+        case Interpolation::allpass:    processChunks<AllpassInterpolator> (channels, numChannelsToProcess, offset, numSamples); break;
+        case Interpolation::catmullRom:
+        default:                        processChunks<CatmullRomInterpolator> (channels, numChannelsToProcess, offset, numSamples); break;
+    }
+}
+
+template <typename Interp, typename SampleType>
+void ChorusEngine::processChunks (SampleType* const* channels, int numChannelsToProcess, int startOffset, int numSamples)
+{
+    const int endOffset = startOffset + numSamples;
+
+    for (int offset = startOffset; offset < endOffset; offset += chunkFrames)
+    {
+        const int chunkSize = std::min (chunkFrames, endOffset - offset);
+
+        // RAMPAS - solo si algun parametro se esta moviendo (rate en processLfo)
+        const bool depthChanging = depthRamp.isRamping();
+        const bool gainsChanging = depthChanging || mixRamp.isRamping() || switchRamp.isRamping();
+
+        if (gainsChanging)
+            buildGainRamps (chunkSize, depthChanging, mixRamp.isRamping());
+
+        if (decorrelated)
+        {
+            // Sin plan comun: cada carril calcula su lectura a partir del mismo LFO
+            processLfo (chunkSize);
+
+            if (laneWidth == Float4::width)
+            {
+                if (gainsChanging) processChunkDecorrelated<Interp, Float4, true> (channels, numChannelsToProcess, offset, chunkSize);
+                else               processChunkDecorrelated<Interp, Float4, false> (channels, numChannelsToProcess, offset, chunkSize);
+            }
+            else
+            {
+                if (gainsChanging) processChunkDecorrelated<Interp, Float8, true> (channels, numChannelsToProcess, offset, chunkSize);
+                else               processChunkDecorrelated<Interp, Float8, false> (channels, numChannelsToProcess, offset, chunkSize);
+            }
+
+            writePosition = (writePosition + chunkSize) & delayLine.getMask();
+            continue;
+        }
+
+        if (params.voices <= Float4::width)
+        {
+            if (depthChanging) buildTapPlan<Interp, Float4, true> (chunkSize);
+            else               buildTapPlan<Interp, Float4, false> (chunkSize);
+        }
+        else
+        {
+            if (depthChanging) buildTapPlan<Interp, Float8, true> (chunkSize);
+            else               buildTapPlan<Interp, Float8, false> (chunkSize);
+        }
+
+        if (laneWidth == Float4::width)
+        {
+            if (gainsChanging) processChunk<Interp, Float4, true> (channels, numChannelsToProcess, offset, chunkSize);
+            else               processChunk<Interp, Float4, false> (channels, numChannelsToProcess, offset, chunkSize);
+        }
+        else
+        {
+            if (gainsChanging) processChunk<Interp, Float8, true> (channels, numChannelsToProcess, offset, chunkSize);
+            else               processChunk<Interp, Float8, false> (channels, numChannelsToProcess, offset, chunkSize);
+        }
+
+        writePosition = (writePosition + chunkSize) & delayLine.getMask();
+    }
+}
+
+
+template <typename SampleType>
+bool ChorusEngine::isSilent (SampleType* const* channels, int numChannelsToProcess, int numSamples) const
+{
+    // Comparacion sin saltos ni maximo encadenado: el bucle se vectoriza y en
+    // reposo este recorrido es casi todo el coste del bloque
+    const auto threshold = static_cast<SampleType> (silenceThreshold);
+
+    for (int ch = 0; ch < numChannelsToProcess; ++ch)
+    {
+        const SampleType* data = channels[ch];
+        int loudSamples = 0;
+        for (int i = 0; i < numSamples; ++i)
+            loudSamples += std::abs (data[i]) > threshold ? 1 : 0;
+
+        if (loudSamples > 0)
+            return false;
+    }
+
+    return true;
+}
+
+template <typename SampleType>
+void ChorusEngine::processIdle (SampleType* const* channels, int numChannelsToProcess, int numSamples)
+{
+    KORUZ_TRACE_SCOPE (traceRing, "idle");
+
+    // El delay line se queda como estaba (solo contiene silencio) y writePosition
+    // no avanza. LFO y rampas avanzan en forma cerrada (por pasos del LFO, no por
+    // frame) y quedan bit a bit como si se hubiera procesado: al retomar el estado
+    // no depende de en que bloque empezo el reposo, asi que tampoco del tamano de bloque
+    advanceLfo (numSamples);
+    depthRamp.skip (numSamples);
+
+    const float dryGain = 1.0f - mixRamp.skip (numSamples);
+    if (dryGain == 1.0f)
+        return;
+
+    for (int ch = 0; ch < numChannelsToProcess; ++ch)
+        for (int i = 0; i < numSamples; ++i)
+            channels[ch][i] *= dryGain;
+}
+
+void ChorusEngine::processLfo (int numSamples)
+{
+    KORUZ_TRACE_SCOPE (traceRing, "lfo");
+
+    // RATE POR PASOS DEL LFO - la rampa avanza un paso (ChorusLfo::stepFrames) en
+    // cada borde de la rejilla del LFO, no una vez por bloque o por tramo: la
+    // trayectoria no depende del tamano de bloque ni de la memoria de trabajo
+    int done = 0;
+    while (done < numSamples && rateRamp.isRamping())
+    {
+        if (lfo.isAtStepStart())
+            lfo.setRate (rateRamp.skip (ChorusLfo::stepFrames));
+
+        const int n = std::min (numSamples - done, lfo.getFramesToNextStep());
+        lfo.process (lfoSin + done, lfoCos + done, n);
+        done += n;
+    }
+
+    if (done < numSamples)
+        lfo.process (lfoSin + done, lfoCos + done, numSamples - done);
+}
+
+void ChorusEngine::advanceLfo (int numSamples)
+{
+    // Como processLfo, sin escribir seno y coseno
+    int done = 0;
+    while (done < numSamples && rateRamp.isRamping())
+    {
+        if (lfo.isAtStepStart())
+            lfo.setRate (rateRamp.skip (ChorusLfo::stepFrames));
+
+        const int n = std::min (numSamples - done, lfo.getFramesToNextStep());
+        lfo.advance (n);
+        done += n;
+    }
+
+    lfo.advance (numSamples - done);
+}
+
+float ChorusEngine::computeWetGain (float depth, float mix, int voices)
+{
+    // SUAVIZADO ADAPTATIVO - menos wet con depth alto
+    float adaptiveSmoothing = 1.0f;
+    if (depth > 0.3f)
+        adaptiveSmoothing = 1.0f - ((depth - 0.3f) / 0.7f) * 0.2f;
+
+    return mix * 0.95f * adaptiveSmoothing / static_cast<float> (voices);
+}
+
+void ChorusEngine::buildGainRamps (int numSamples, bool depthChanging, bool mixChanging)
+{
+    KORUZ_TRACE_SCOPE (traceRing, "gain ramps");
+
+    float* depths = depthValues;
+    float* wet = wetGains;
+    float* dry = dryGains;
+
+    // El parametro quieto se rellena con su valor; dry hace de temporal para mix y
+    // wet para el fundido de estructura
+    if (depthChanging)
+        depthRamp.fill (depths, numSamples);
+    else
+        std::fill (depths, depths + numSamples, depthRamp.getCurrent());
+
+    if (mixChanging)
+        mixRamp.fill (dry, numSamples);
+    else
+        std::fill (dry, dry + numSamples, mixRamp.getCurrent());
+
+    if (switchRamp.isRamping())
+        switchRamp.fill (wet, numSamples);
+    else
+        std::fill (wet, wet + numSamples, switchRamp.getCurrent());
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const float mix = dry[i];
+        wet[i] *= computeWetGain (depths[i], mix, params.voices);
+        dry[i] = 1.0f - mix;
+    }
+}
+
+template <typename Interp, typename Vec, bool rampDepth>
+void ChorusEngine::buildTapPlan (int numSamples)
+{
+    // LFO UNA VEZ POR FRAME, COMPARTIDO POR TODOS LOS CANALES
+    processLfo (numSamples);
+
+    KORUZ_TRACE_SCOPE (traceRing, "tap plan");
+
+    // Todas las voces a la vez, una por carril (Float4 hasta 4 voces, Float8 hasta 8)
+    static_assert (Vec::width <= maxVoices, "one voice per lane");
+
+    const int numVoices = params.voices;
+    const int mask = delayLine.getMask();
+
+    // CURVA DE DEPTH OPTIMIZADA - RANGO MUSICAL 15-22ms
+    const float depth = depthRamp.getCurrent();
+    auto depthCurve = Vec::broadcast (depth * depth);
+    const auto baseDelayMs = Vec::broadcast (15.0f);
+    const auto depthRangeMs = Vec::broadcast (7.0f);
+    const auto samplesPerMs = Vec::broadcast (static_cast<float> (currentSampleRate / 1000.0));
+    const auto minDelay = Vec::broadcast (10.0f);
+    const auto maxDelay = Vec::broadcast (static_cast<float> (delayLine.getCapacity() - 10));
+    const auto half = Vec::broadcast (0.5f);
+    const auto one = Vec::broadcast (1.0f);
+    const auto phaseCos = Vec::load (voiceCos);
+    const auto phaseSin = Vec::load (voiceSin);
+
+    alignas (32) int delayCeil[Vec::width];
+    auto lastDelayMs = Vec::broadcast (0.0f);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        if constexpr (rampDepth)
+            depthCurve = Vec::broadcast (depthValues[(size_t) i] * depthValues[(size_t) i]);
+
+        const auto lfoValue = half + half * (phaseCos * Vec::broadcast (lfoSin[(size_t) i])
+                                             + phaseSin * Vec::broadcast (lfoCos[(size_t) i]));
+
+        const auto modulatedDepth = depthCurve * lfoValue;
+        const auto delayTimeMs = baseDelayMs + depthRangeMs * modulatedDepth;
+        const auto delayTimeSamples = Vec::min (Vec::max (delayTimeMs * samplesPerMs, minDelay), maxDelay);
+        lastDelayMs = delayTimeMs;
+
+        // Posicion de lectura = writePos - delay, separada en entero y fraccion
+        // sin pasar por un float grande: idx1 = writePos - ceil(delay), frac = ceil(delay) - delay
+        const auto ceilDelay = Vec::truncate (delayTimeSamples) + one;
+        const auto frac = ceilDelay - delayTimeSamples;
+        ceilDelay.storeTruncated (delayCeil);
+
+        int* indices = tapIndices + i * maxVoices;
+        for (int v = 0; v < numVoices; ++v)
+            indices[v] = (writePosition + i - delayCeil[v] + Interp::firstTap) & mask;
+
+        Interp::computeWeights (frac, tapWeights + i * maxTaps * maxVoices, maxVoices);
+    }
+
+    alignas (32) float delayMs[Vec::width];
+    lastDelayMs.store (delayMs);
+    currentDelayMs = delayMs[0];
+}
+
+template <typename Interp, typename Vec, bool rampGains, typename SampleType>
+void ChorusEngine::processChunk (SampleType* const* channels, int numChannelsToProcess, int offset, int numSamples)
+{
+    constexpr int W = Vec::width;
+    const int mask = delayLine.getMask();
+    const int numVoices = params.voices;
+
+    // MEZCLA - constantes en todo el bloque salvo durante una rampa
+    auto wetGain = Vec::broadcast (computeWetGain (depthRamp.getCurrent(), mixRamp.getCurrent(), numVoices) * switchRamp.getCurrent());
+    auto dryGain = Vec::broadcast (1.0f - mixRamp.getCurrent());
+    const auto inputGain = Vec::broadcast (0.999f);
+    const auto threshold = Vec::broadcast (kernelClipLevel);
+    const auto negThreshold = Vec::broadcast (-kernelClipLevel);
+    const auto kneeSlope = Vec::broadcast (0.3f);
+
+    float* frames = frameBuffer;
+
+    for (int g = 0; g < numGroups; ++g)
+    {
+        const int firstChannel = g * W;
+        const int groupChannels = std::min (W, numChannelsToProcess - firstChannel);
+        if (groupChannels <= 0)
+            break;
+
+        // Escritura, interpolacion y mezcla van fundidas en una pasada por frame (y la
+        // rodilla, si no va a 2x)
+        KORUZ_TRACE_SCOPE (traceRing, "write/interpolate/mix");
+
+        interleave (channels, firstChannel, groupChannels, offset, numSamples, frames, W);
+
+        float* delayData = delayLine.getGroup (g);
+
+        // Estado del allpass de este grupo (para el resto de politicas no se usa)
+        Vec previous[maxVoices];
+        float* state = allpassState + g * maxVoices * W;
+        for (int v = 0; v < numVoices; ++v)
+            previous[v] = Interp::hasState ? Vec::load (state + v * W) : Vec::broadcast (0.0f);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto input = Vec::load (frames + i * W);
+
+            // ESCRITURA EN BUFFER
+            delayLine.write (delayData, (writePosition + i) & mask, input * inputGain);
+
+            // INTERPOLACIÓN por voz, ventana contigua sin envolver
+            const int* indices = tapIndices + i * maxVoices;
+            const float* weights = tapWeights + i * maxTaps * maxVoices;
+            auto delayed = Vec::broadcast (0.0f);
+
+            for (int v = 0; v < numVoices; ++v)
+                delayed = delayed + Interp::read (delayLine.getWindow (delayData, indices[v]), weights + v, maxVoices, previous[v]);
+
+            // MEZCLA DRY/WET
+            if constexpr (rampGains)
+            {
+                wetGain = Vec::broadcast (wetGains[(size_t) i]);
+                dryGain = Vec::broadcast (dryGains[(size_t) i]);
+            }
+
+            auto output = input * dryGain + delayed * wetGain;
+
+            // PROTECCIÓN CONTRA CLIPPING
+            output = Vec::select (Vec::greaterThan (output, threshold), threshold + (output - threshold) * kneeSlope,
+                     Vec::select (Vec::lessThan (output, negThreshold), negThreshold + (output - negThreshold) * kneeSlope,
+                                  output));
+
+            output.store (frames + i * W);
+        }
+
+        if constexpr (Interp::hasState)
+            for (int v = 0; v < numVoices; ++v)
+                previous[v].store (state + v * W);
+
+        deinterleave (frames, W, channels, firstChannel, groupChannels, offset, numSamples);
+    }
+}
+
+template <typename Interp, typename Vec, bool rampGains, typename SampleType>
+void ChorusEngine::processChunkDecorrelated (SampleType* const* channels, int numChannelsToProcess, int offset, int numSamples)
+{
+    constexpr int W = Vec::width;
+    const int mask = delayLine.getMask();
+    const int numVoices = params.voices;
+
+    // MEZCLA - constantes en todo el bloque salvo durante una rampa
+    auto wetGain = Vec::broadcast (computeWetGain (depthRamp.getCurrent(), mixRamp.getCurrent(), numVoices) * switchRamp.getCurrent());
+    auto dryGain = Vec::broadcast (1.0f - mixRamp.getCurrent());
+    const auto inputGain = Vec::broadcast (0.999f);
+    const auto threshold = Vec::broadcast (kernelClipLevel);
+    const auto negThreshold = Vec::broadcast (-kernelClipLevel);
+    const auto kneeSlope = Vec::broadcast (0.3f);
+
+    // CURVA DE DEPTH OPTIMIZADA - RANGO MUSICAL 15-22ms (como en buildTapPlan, por carril)
+    auto depthCurve = Vec::broadcast (depthRamp.getCurrent() * depthRamp.getCurrent());
+    const auto baseDelayMs = Vec::broadcast (15.0f);
+    const auto depthRangeMs = Vec::broadcast (7.0f);
+    const auto samplesPerMs = Vec::broadcast (static_cast<float> (currentSampleRate / 1000.0));
+    const auto minDelay = Vec::broadcast (10.0f);
+    const auto maxDelay = Vec::broadcast (static_cast<float> (delayLine.getCapacity() - 10));
+    const auto half = Vec::broadcast (0.5f);
+    const auto one = Vec::broadcast (1.0f);
+
+    // Indices en float (enteros exactos por debajo de 2^24): la envoltura es
+    // x - floor (x / capacidad) * capacidad, exacta con capacidad potencia de dos
+    const int capacity = delayLine.getCapacity();
+    const auto capacityVec = Vec::broadcast (static_cast<float> (capacity));
+    const auto inverseCapacity = Vec::broadcast (1.0f / static_cast<float> (capacity));
+
+    alignas (32) int positions[W];
+    alignas (32) float weights[maxTaps * W];
+    alignas (32) float written[W];
+    float* frames = frameBuffer;
+
+    for (int g = 0; g < numGroups; ++g)
+    {
+        const int firstChannel = g * W;
+        const int groupChannels = std::min (W, numChannelsToProcess - firstChannel);
+        if (groupChannels <= 0)
+            break;
+
+        // Escritura, interpolacion y mezcla van fundidas en una pasada por frame (y la
+        // rodilla, si no va a 2x)
+        KORUZ_TRACE_SCOPE (traceRing, "write/interpolate/mix");
+
+        interleave (channels, firstChannel, groupChannels, offset, numSamples, frames, W);
+
+        float* delayData = delayLine.getGroup (g);
+        const auto laneStride = static_cast<size_t> (delayLine.getLane (delayData, 1) - delayData);
+
+        // Fase de cada voz en cada carril del grupo, y estado del allpass
+        Vec phaseCos[maxVoices], phaseSin[maxVoices], previous[maxVoices];
+        float* state = allpassState + g * maxVoices * W;
+        for (int v = 0; v < numVoices; ++v)
+        {
+            phaseCos[v] = Vec::load (laneCos + v * maxChannels + firstChannel);
+            phaseSin[v] = Vec::load (laneSin + v * maxChannels + firstChannel);
+            previous[v] = Interp::hasState ? Vec::load (state + v * W) : Vec::broadcast (0.0f);
+        }
+
+        auto firstVoiceDelayMs = Vec::broadcast (0.0f);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto input = Vec::load (frames + i * W);
+
+            // ESCRITURA EN BUFFER - un valor por tramo de carril
+            (input * inputGain).store (written);
+            for (int lane = 0; lane < W; ++lane)
+                delayLine.writeLane (delayLine.getLane (delayData, lane), (writePosition + i) & mask, written[lane]);
+
+            if constexpr (rampGains)
+                depthCurve = Vec::broadcast (depthValues[(size_t) i] * depthValues[(size_t) i]);
+
+            const auto sinValue = Vec::broadcast (lfoSin[(size_t) i]);
+            const auto cosValue = Vec::broadcast (lfoCos[(size_t) i]);
+            const auto readBase = Vec::broadcast (static_cast<float> (writePosition + i + Interp::firstTap + capacity));
+            auto delayed = Vec::broadcast (0.0f);
+
+            for (int v = 0; v < numVoices; ++v)
+            {
+                // LFO rotado a la fase de cada carril
+                const auto lfoValue = half + half * (phaseCos[v] * sinValue + phaseSin[v] * cosValue);
+                const auto delayTimeMs = baseDelayMs + depthRangeMs * (depthCurve * lfoValue);
+                const auto delayTimeSamples = Vec::min (Vec::max (delayTimeMs * samplesPerMs, minDelay), maxDelay);
+
+                if (v == 0)
+                    firstVoiceDelayMs = delayTimeMs;
+
+                const auto ceilDelay = Vec::truncate (delayTimeSamples) + one;
+                const auto frac = ceilDelay - delayTimeSamples;
+
+                // INTERPOLACIÓN por carril: cada uno en su ventana, coeficientes por carril
+                auto position = readBase - ceilDelay;
+                position = position - Vec::truncate (position * inverseCapacity) * capacityVec;
+                position.storeTruncated (positions);
+
+                Vec taps[Interp::numTaps];
+                loadLaneTaps<Interp::numTaps> (delayData, laneStride, positions, taps);
+                Interp::computeWeights (frac, weights, W);
+                delayed = delayed + Interp::readLanes (taps, weights, W, previous[v]);
+            }
+
+            // MEZCLA DRY/WET
+            if constexpr (rampGains)
+            {
+                wetGain = Vec::broadcast (wetGains[(size_t) i]);
+                dryGain = Vec::broadcast (dryGains[(size_t) i]);
+            }
+
+            auto output = input * dryGain + delayed * wetGain;
+
+            // PROTECCIÓN CONTRA CLIPPING
+            output = Vec::select (Vec::greaterThan (output, threshold), threshold + (output - threshold) * kneeSlope,
+                     Vec::select (Vec::lessThan (output, negThreshold), negThreshold + (output - negThreshold) * kneeSlope,
+                                  output));
+
+            output.store (frames + i * W);
+        }
+
+        if constexpr (Interp::hasState)
+            for (int v = 0; v < numVoices; ++v)
+                previous[v].store (state + v * W);
+
+        if (g == 0)
+        {
+            alignas (32) float delayMs[W];
+            firstVoiceDelayMs.store (delayMs);
+            currentDelayMs = delayMs[0];
+        }
+
+        deinterleave (frames, W, channels, firstChannel, groupChannels, offset, numSamples);
+    }
+}
+
+template void ChorusEngine::process<float> (float* const*, int, int);
+template void ChorusEngine::process<double> (double* const*, int, int);
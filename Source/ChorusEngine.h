@@ -0,0 +1,250 @@
+#pragma once
+
+#include "ChorusLfo.h"
+#include "ChorusWorkspace.h"
+#include "DelayLine.h"
+#include "DspArena.h"
+#include "OversampledClipper.h"
+#include "ParameterRamp.h"
+#include <cstddef>
+#include <limits>
+#include <memory>
+
+class TraceRing;
+
+// Nucleo DSP del chorus, independiente de JUCE.
+// Los canales se procesan juntos: cada frame ocupa un vector SIMD (un canal por
+// carril), asi que un stereo cuesta practicamente lo mismo que un mono.
+// Con varias voces, todas leen del mismo delay line con su propio desfase de LFO.
+// En layouts surround cada canal puede llevar ademas su propio desfase: el LFO
+// se sigue calculando una vez por frame y cada carril lo rota a su fase, asi que
+// cada carril lee en su propia posicion dentro del mismo grupo SIMD (delay line
+// planar por carril, taps traspuestos a vectores).
+// Los cambios de rate/depth/mix se rampean (20ms); con valores quietos el bucle
+// por sample no hace ninguna cuenta de parametros. El rate cambia en los pasos
+// fijos del LFO, asi que la salida no depende de como se trocea el audio.
+// Los cambios de voces o interpolacion no son rampeables: el wet baja a cero
+// (5ms), se cambia la estructura y vuelve a subir, sin clicks.
+// Con entrada en silencio y el delay line ya vaciado el motor pasa a reposo:
+// solo aplica la ganancia dry y avanza el LFO (sin interpolar ni escribir).
+// La rodilla de salida va en el propio bucle, sin latencia; opcionalmente se
+// sobremuestrea a 2x (OversampledClipper), solo en los tramos en los que actua,
+// a cambio de latencySamples de latencia.
+// Todo el estado (delay line, historias, rampas) sale de un DspArena: con
+// reserve() para la mayor configuracion, prepare() no reserva memoria. La memoria
+// de trabajo de cada tramo (plan de lectura, LFO, ganancias) no es estado: sale de
+// un ChorusWorkspacePool compartido por todas las instancias del proceso, y solo
+// si esta lleno de una propia de fallbackChunkFrames.
+class ChorusEngine
+{
+public:
+    static constexpr int maxVoices = 8;
+    static constexpr int maxChannels = 16;   // 7.1.4 (12) en dos grupos Float8
+    static constexpr int maxTaps = 6;   // LagrangeInterpolator
+    static constexpr double rampTimeSeconds = 0.02;
+    static constexpr double switchFadeSeconds = 0.005;   // cada mitad del fundido de estructura
+    static constexpr double maxDelaySeconds = 0.022;   // 15ms + 7ms de depth
+    static constexpr int maxChunkFrames = ChorusWorkspacePool::chunkFrames;   // bloques mayores se procesan por tramos
+    static constexpr int fallbackChunkFrames = 64;   // tramo con la memoria de trabajo propia
+    static constexpr float silenceThreshold = 1.0e-6f;  // -120 dBFS
+
+    // Interpolacion del tap de lectura (ver Interpolators.h).
+    // El plugin expone linear/catmullRom/lagrange como calidad Eco/Normal/HQ
+    enum class Interpolation { linear, catmullRom, lagrange, allpass };
+
+    struct Parameters
+    {
+        float rate = 0.8f;    // Hz
+        float depth = 0.4f;   // 0..1
+        float mix = 0.5f;     // 0..1
+        int voices = 1;       // taps por canal, 1..maxVoices
+        Interpolation interpolation = Interpolation::catmullRom;
+    };
+
+    ChorusEngine() = default;
+
+    // Cola del host; el vaciado antes del reposo es el mayor entre esto y el delay maximo
+    void setTailLength (double seconds) { tailSeconds = seconds; }
+
+    // Reserva la memoria para cualquier prepare hasta maxSampleRate/maxNumChannels.
+    // Opcional: sin ella (o si se supera) prepare reserva lo que le falte
+    void reserve (double maxSampleRate, int maxNumChannels);
+    static size_t getRequiredBytes (double sampleRate, int numChannels);
+    size_t getReservedBytes() const { return arena.getCapacity(); }
+
+    // Memoria de la instancia (el objeto y su arena) y la compartida con los demas
+    // motores del proceso; la compartida se cuenta una vez, no por instancia
+    struct MemoryUsage
+    {
+        size_t instanceBytes = 0;
+        size_t sharedBytes = 0;
+        int sharingEngines = 0;
+    };
+
+    MemoryUsage getMemoryUsage() const;
+
+    void prepare (double sampleRate, int numChannels, int maxBlockSize);
+    void reset();
+
+    // Deja el motor sin preparar; la memoria se conserva para el siguiente prepare
+    void release();
+
+    void setParameters (const Parameters& newParameters);
+
+    // Desfase del LFO de cada canal, en ciclos (0..1). Con todos a cero (por defecto)
+    // todos los canales comparten la modulacion y se usa el plan de lectura comun.
+    // Pasar de no tener desfases a tenerlos (o al reves) vacia el delay line:
+    // llamar antes de prepare o con el audio parado
+    void setChannelPhaseOffsets (const float* cycles, int count);
+    bool hasChannelPhaseOffsets() const { return decorrelated; }
+
+    // Desfase del LFO de un canal en ciclos: cero en mono/stereo (modulacion comun,
+    // como siempre); en surround, reparto por proporcion aurea para que canales
+    // vecinos queden lo mas separados posible con cualquier numero de canales
+    static float getLayoutPhaseOffset (int channel, int numChannels);
+
+    // Rodilla a 2x o en el propio bucle (por defecto), sin latencia. Se puede cambiar
+    // entre dos process (vacia las historias del sobremuestreo), pero cambia la
+    // latencia que hay que reportar al host
+    void setClipOversampling (bool shouldOversample);
+    bool isClipOversampling() const { return clipOversampling; }
+    int getLatencySamples() const { return clipOversampling ? OversampledClipper::latencySamples : 0; }
+
+    // Parametros en uso; voces e interpolacion pueden ir por detras durante un fundido
+    const Parameters& getParameters() const { return params; }
+    bool isSwitchingStructure() const { return switchPending || switchRamp.isRamping(); }
+
+    // Procesa in-place; numChannels puede ser menor que el preparado.
+    // SampleType es float o double: el calculo interno es siempre en float y la
+    // conversion se hace al intercalar/desintercalar, sin buffers intermedios
+    template <typename SampleType>
+    void process (SampleType* const* channels, int numChannels, int numSamples);
+
+    bool isPrepared() const { return prepared; }
+    int getNumChannels() const { return numChannels; }
+    int getDelayBufferSize() const { return delayLine.getCapacity(); }
+
+    // Estado para la visualizacion, actualizado en cada process
+    double getLfoPhase() const { return lfo.getPhase(); }
+    void setLfoPhase (double phase) { lfo.setPhase (phase); }
+    float getCurrentDelayMs() const { return currentDelayMs; }
+
+    // Anillo de trazas (KORUZ_TRACE) del dueno; lo escribe el hilo que llama a prepare
+    // o process, nunca dos a la vez. nullptr (por defecto) no traza
+    void setTraceRing (TraceRing* ring) { traceRing = ring; }
+
+    bool isIdle() const { return idle; }
+    unsigned long long getSkippedBlocks() const { return skippedBlocks; }
+    unsigned long long getOversampledBlocks() const { return clipper.getEngagedBlocks(); }   // process con algun canal a 2x
+
+private:
+    template <typename SampleType>
+    void processBlock (SampleType* const* channels, int numChannelsToProcess, int numSamples);
+
+    template <typename SampleType>
+    void processSegment (SampleType* const* channels, int numChannelsToProcess, int offset, int numSamples);
+
+    template <typename Interp, typename SampleType>
+    void processChunks (SampleType* const* channels, int numChannelsToProcess, int startOffset, int numSamples);
+
+    template <typename Interp, typename Vec, bool rampDepth>
+    void buildTapPlan (int numSamples);
+
+    template <typename Interp, typename Vec, bool rampGains, typename SampleType>
+    void processChunk (SampleType* const* channels, int numChannelsToProcess, int offset, int numSamples);
+
+    template <typename Interp, typename Vec, bool rampGains, typename SampleType>
+    void processChunkDecorrelated (SampleType* const* channels, int numChannelsToProcess, int offset, int numSamples);
+
+    template <typename SampleType>
+    bool isSilent (SampleType* const* channels, int numChannelsToProcess, int numSamples) const;
+
+    template <typename SampleType>
+    void processIdle (SampleType* const* channels, int numChannelsToProcess, int numSamples);
+
+    template <typename SampleType>
+    void processClipper (SampleType* const* channels, int numChannelsToProcess, int numSamples);
+
+    void processLfo (int numSamples);
+    void advanceLfo (int numSamples);
+    void useWorkspace (const ChorusWorkspace& workspace);
+    void applyStructure (int voices, Interpolation interpolation);
+    void updateLanePhases();
+    void buildGainRamps (int numSamples, bool depthChanging, bool mixChanging);
+    static float computeWetGain (float depth, float mix, int voices);
+
+    ChorusLfo lfo;
+    Parameters params;
+
+    // Rampas hacia params; rate es exponencial y avanza por pasos del LFO
+    ParameterRamp rateRamp { ParameterRamp::Shape::exponential };
+    ParameterRamp depthRamp;
+    ParameterRamp mixRamp;
+
+    // Fundido del wet para cambios de estructura; el cambio pendiente se aplica en cero
+    ParameterRamp switchRamp;
+    bool switchPending = false;
+    int pendingVoices = 1;
+    Interpolation pendingInterpolation = Interpolation::catmullRom;
+
+    double currentSampleRate = 44100.0;
+    int numChannels = 0;
+    int laneWidth = 4;
+    int numGroups = 0;
+    int maxChunk = 0;
+
+    // Desfase de cada voz (v / voces de ciclo) como cos/sin, ceros si la voz no se usa
+    alignas (32) float voiceCos[maxVoices] = { 1.0f };
+    alignas (32) float voiceSin[maxVoices] = {};
+
+    // Con desfase por canal: desfase de voz + canal como cos/sin [voz][canal];
+    // los carriles de un grupo son contiguos
+    float channelPhase[maxChannels] = {};
+    bool decorrelated = false;
+    alignas (32) float laneCos[maxVoices * maxChannels] = {};
+    alignas (32) float laneSin[maxVoices * maxChannels] = {};
+
+    DspArena arena;
+    DelayLine delayLine;
+    int writePosition = 0;
+
+    // Deteccion de silencio
+    double tailSeconds = 0.0;
+    int drainFrames = 0;
+    int silentFrames = 0;
+    bool idle = false;
+    unsigned long long skippedBlocks = 0;
+
+    // Rodilla de salida; con el clipper activo el bucle no la aplica (umbral inalcanzable)
+    OversampledClipper clipper;
+    bool clipOversampling = false;
+    float kernelClipLevel = OversampledClipper::threshold;
+
+    // Memoria de trabajo: la del pool compartido si hay hueco, si no la propia
+    std::shared_ptr<ChorusWorkspacePool> workspacePool;
+    int lastWorkspaceSlot = 0;   // primer hueco que se intenta (cache caliente)
+    ChorusWorkspace ownWorkspace;
+    int chunkFrames = 0;
+
+    // Plan de lectura por frame y voz, compartido por todos los grupos:
+    // primer frame de la ventana [frame][voz] y coeficientes [frame][tap][voz]
+    float* lfoSin = nullptr;
+    float* lfoCos = nullptr;
+    int* tapIndices = nullptr;
+    float* tapWeights = nullptr;
+
+    // Salida anterior de cada voz y carril [grupo][voz][carril], solo para el allpass
+    float* allpassState = nullptr;
+    size_t allpassStateSize = 0;
+
+    // Valores por frame, solo se rellenan mientras alguna rampa esta activa
+    float* depthValues = nullptr;
+    float* wetGains = nullptr;
+    float* dryGains = nullptr;
+
+    float* frameBuffer = nullptr;
+    float* clipScratch = nullptr;
+    float currentDelayMs = 0.0f;
+    TraceRing* traceRing = nullptr;
+    bool prepared = false;
+};
@@ -0,0 +1,204 @@
+#include "ChorusLfo.h"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+
+namespace
+{
+    constexpr double twoPi = 6.283185307179586476925286766559;
+    constexpr float smoothingPole = 0.9995f;
+    constexpr float smoothingGain = 0.0005f;
+
+    constexpr double getStepPole()
+    {
+        double pole = 1.0;
+        for (int i = 0; i < ChorusLfo::stepFrames; ++i)
+            pole *= smoothingPole;
+
+        return pole;
+    }
+
+    constexpr double stepPole = getStepPole();   // a^stepFrames
+}
+
+void ChorusLfo::prepare (double sampleRate)
+{
+    currentSampleRate = sampleRate;
+    rate = -1.0f;
+    reset();
+}
+
+void ChorusLfo::reset()
+{
+    stepPhase = 0.0;
+    stepPosition = 0;
+    stepsSinceResync = resyncSteps;
+    smoothedS = 0.0f;
+    smoothedC = 0.0f;
+}
+
+void ChorusLfo::setRate (float rateHz)
+{
+    pendingRate = rateHz;
+}
+
+double ChorusLfo::getPhase() const
+{
+    const double phase = stepPhase + phaseIncrement * stepPosition;
+    return phase - std::floor (phase);
+}
+
+void ChorusLfo::setPhase (double newPhase)
+{
+    // La rejilla de pasos no se mueve: solo cambia la fase de este paso
+    stepPhase = newPhase - phaseIncrement * stepPosition;
+    stepPhase -= std::floor (stepPhase);
+    resync();
+}
+
+void ChorusLfo::applyRate (float rateHz)
+{
+    using Complex = std::complex<double>;
+
+    rate = rateHz;
+    phaseIncrement = rate / currentSampleRate;
+    cosIncrement = std::cos (twoPi * phaseIncrement);
+    sinIncrement = std::sin (twoPi * phaseIncrement);
+
+    // Paso completo: z^n y la entrada del filtro sum a^(n-1-k) * z^k = (a^n - z^n) / (a - z)
+    const Complex z (cosIncrement, sinIncrement);
+    const Complex zN = std::polar (1.0, twoPi * phaseIncrement * stepFrames);
+    const Complex input = static_cast<double> (smoothingGain) * (stepPole - zN) / (static_cast<double> (smoothingPole) - z);
+
+    stepRotationS = zN.imag();
+    stepRotationC = zN.real();
+    stepInputS = input.imag();
+    stepInputC = input.real();
+}
+
+void ChorusLfo::resync()
+{
+    // La fase avanza antes de evaluar el seno, como en el bucle original
+    oscillatorS = std::sin (twoPi * (getPhase() + phaseIncrement));
+    oscillatorC = std::cos (twoPi * (getPhase() + phaseIncrement));
+
+    // A mitad de paso (setPhase) el paso cuenta como empezado en la fase nueva
+    stepOscillatorS = stepPosition == 0 ? oscillatorS : std::sin (twoPi * (stepPhase + phaseIncrement));
+    stepOscillatorC = stepPosition == 0 ? oscillatorC : std::cos (twoPi * (stepPhase + phaseIncrement));
+    stepsSinceResync = 0;
+}
+
+void ChorusLfo::beginStep()
+{
+    if (pendingRate != rate)
+    {
+        applyRate (pendingRate);
+        resync();
+    }
+    else if (++stepsSinceResync >= resyncSteps)
+    {
+        resync();
+    }
+
+    stepOscillatorS = oscillatorS;
+    stepOscillatorC = oscillatorC;
+    stepSmoothedS = smoothedS;
+    stepSmoothedC = smoothedC;
+}
+
+void ChorusLfo::finishStep()
+{
+    // Estado al final del paso desde el del principio, sin pasar por la recursion:
+    // m_n = a^n * m_0 + entrada * z0 (complejos c + j*s)
+    const double s0 = stepOscillatorS;
+    const double c0 = stepOscillatorC;
+
+    smoothedS = static_cast<float> (stepPole * stepSmoothedS + (stepInputC * s0 + stepInputS * c0));
+    smoothedC = static_cast<float> (stepPole * stepSmoothedC + (stepInputC * c0 - stepInputS * s0));
+
+    oscillatorS = s0 * stepRotationC + c0 * stepRotationS;
+    oscillatorC = c0 * stepRotationC - s0 * stepRotationS;
+}
+
+void ChorusLfo::endFrames (int numSamples)
+{
+    // La fase del paso se acumula por pasos enteros: la misma suma con cualquier troceado
+    const int frames = stepPosition + numSamples;
+    const int steps = frames / stepFrames;
+    stepPosition = frames - steps * stepFrames;
+
+    if (steps > 0)
+    {
+        stepPhase += phaseIncrement * static_cast<double> (steps * stepFrames);
+        stepPhase -= std::floor (stepPhase);
+    }
+}
+
+template <bool writeOutput>
+void ChorusLfo::runFrames (float* smoothedSin, float* smoothedCos, int numSamples)
+{
+    float ss = smoothedS;
+    float sc = smoothedC;
+    double s = oscillatorS;
+    double c = oscillatorC;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        // Suavizado exponencial del LFO
+        ss = smoothingPole * ss + smoothingGain * static_cast<float> (s);
+        sc = smoothingPole * sc + smoothingGain * static_cast<float> (c);
+
+        if constexpr (writeOutput)
+        {
+            smoothedSin[i] = ss;
+            smoothedCos[i] = sc;
+        }
+
+        const double nextS = s * cosIncrement + c * sinIncrement;
+        c = c * cosIncrement - s * sinIncrement;
+        s = nextS;
+    }
+
+    oscillatorS = s;
+    oscillatorC = c;
+    smoothedS = ss;
+    smoothedC = sc;
+}
+
+void ChorusLfo::process (float* smoothedSin, float* smoothedCos, int numSamples)
+{
+    for (int i = 0; i < numSamples;)
+    {
+        if (stepPosition == 0)
+            beginStep();
+
+        const int n = std::min (numSamples - i, getFramesToNextStep());
+        runFrames<true> (smoothedSin + i, smoothedCos + i, n);
+
+        if (n == getFramesToNextStep())
+            finishStep();
+
+        endFrames (n);
+        i += n;
+    }
+}
+
+void ChorusLfo::advance (int numSamples)
+{
+    while (numSamples > 0)
+    {
+        if (stepPosition == 0)
+            beginStep();
+
+        // Pasos completos en forma cerrada; solo un paso a medias usa la recursion
+        const int n = std::min (numSamples, getFramesToNextStep());
+
+        if (n == getFramesToNextStep())
+            finishStep();
+        else
+            runFrames<false> (nullptr, nullptr, n);
+
+        endFrames (n);
+        numSamples -= n;
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cmath>
+
+// LFO del chorus calculado una vez por frame y compartido por todos los canales.
+// Oscilador de cuadratura recursivo sobre una rejilla fija de pasos de stepFrames
+// frames, contada desde prepare/reset:
+// - el rate solo cambia al empezar un paso (setRate deja el nuevo pendiente);
+// - sin/cos se recalculan desde la fase al cambiar el rate y cada resyncSteps
+//   pasos, asi que no hay deriva.
+// - al acabar cada paso, oscilador y suavizado se fijan en forma cerrada desde el
+//   estado con que empezo (una rotacion de stepFrames y la suma geometrica del
+//   filtro); los frames de dentro del paso salen de la recursion.
+// Como nada depende de donde empieza o acaba cada llamada, la salida es la misma
+// con cualquier troceado (tamano de bloque del host o tramo del motor), y advance
+// deja exactamente el mismo estado que process con un coste por paso, no por frame.
+//
+// Se entregan seno y coseno suavizados (filtro de un polo 0.9995). Como el
+// suavizado es lineal, el LFO de cualquier voz con desfase phi es
+// 0.5 + 0.5 * (cos(phi) * sinSuavizado + sin(phi) * cosSuavizado).
+class ChorusLfo
+{
+public:
+    static constexpr int stepFrames = 32;
+    static constexpr int resyncSteps = 16;   // 512 frames
+
+    void prepare (double sampleRate);
+    void reset();
+
+    // Entra al empezar el siguiente paso
+    void setRate (float rateHz);
+
+    // Escribe numSamples valores de seno y coseno suavizados (-1..1), uno por frame
+    void process (float* smoothedSin, float* smoothedCos, int numSamples);
+
+    // Avanza numSamples sin generar nada: los pasos completos en forma cerrada y
+    // solo los frames de un paso a medias por la recursion. Deja el LFO bit a bit
+    // igual que si se hubiera llamado a process
+    void advance (int numSamples);
+
+    // Frames que quedan del paso actual; stepFrames en el borde de un paso
+    int getFramesToNextStep() const { return stepFrames - stepPosition; }
+    bool isAtStepStart() const { return stepPosition == 0; }
+
+    double getPhase() const;
+    void setPhase (double newPhase);
+    float getSmoothedValue() const { return 0.5f + 0.5f * smoothedS; }
+
+private:
+    void beginStep();
+    void finishStep();
+    void endFrames (int numSamples);
+
+    template <bool writeOutput>
+    void runFrames (float* smoothedSin, float* smoothedCos, int numSamples);
+    void applyRate (float rateHz);
+    void resync();
+
+    double currentSampleRate = 44100.0;
+    double stepPhase = 0.0;      // fase al empezar el paso, ciclos [0, 1)
+    int stepPosition = 0;
+    int stepsSinceResync = 0;
+    double phaseIncrement = 0.0;
+    double cosIncrement = 1.0;
+    double sinIncrement = 0.0;
+    double oscillatorS = 0.0;    // sin/cos del siguiente frame, sin suavizar
+    double oscillatorC = 1.0;
+    double stepOscillatorS = 0.0;   // lo mismo al empezar el paso
+    double stepOscillatorC = 1.0;
+    double stepRotationS = 0.0;     // giro de un paso completo
+    double stepRotationC = 1.0;
+    double stepInputS = 0.0;        // suma del filtro sobre un paso: (1 - a) * sum a^(n-1-k) * z^k
+    double stepInputC = 0.0;
+    float rate = -1.0f;
+    float pendingRate = 0.0f;
+    float smoothedS = 0.0f;
+    float smoothedC = 0.0f;
+    float stepSmoothedS = 0.0f;
+    float stepSmoothedC = 0.0f;
+};
@@ -0,0 +1,286 @@
+#include "ChorusReference.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr double twoPi = 6.283185307179586476925286766559;
+
+    // Suavizados por canal: uno por voz de cada cantidad de voces (1 + 2 + ... + 8)
+    constexpr int smoothersPerChannel = ChorusEngine::maxVoices * (ChorusEngine::maxVoices + 1) / 2;
+}
+
+void ChorusReference::prepare (double newSampleRate, int numChannels)
+{
+    sampleRate = newSampleRate;
+
+    // Mismo tamano que el motor: 35ms (minimo 1024) redondeado a potencia de dos
+    const int minimumSize = std::max (static_cast<int> (sampleRate * 0.035), 1024);
+    size = 1;
+    while (size < minimumSize)
+        size <<= 1;
+
+    delayBuffers.assign (static_cast<size_t> (std::max (numChannels, 1)), std::vector<float> (static_cast<size_t> (size), 0.0f));
+    allpassState.assign (delayBuffers.size() * ChorusEngine::maxVoices, 0.0f);
+    smoothed.assign (delayBuffers.size() * smoothersPerChannel, 0.5f);
+    channelPhase.resize (delayBuffers.size(), 0.0);
+
+    const int rampLength = std::max (static_cast<int> (sampleRate * ChorusEngine::rampTimeSeconds), 1);
+    rateRamp.length = depthRamp.length = mixRamp.length = rampLength;
+    rateRamp.exponential = true;
+    switchRamp.length = std::max (static_cast<int> (sampleRate * ChorusEngine::switchFadeSeconds), 1);
+    reset();
+}
+
+void ChorusReference::reset()
+{
+    for (auto& buffer : delayBuffers)
+        std::fill (buffer.begin(), buffer.end(), 0.0f);
+
+    std::fill (allpassState.begin(), allpassState.end(), 0.0f);
+    std::fill (smoothed.begin(), smoothed.end(), 0.5f);
+    writePosition = 0;
+    phase = 0.0;
+    frameCount = 0;
+    started = false;
+}
+
+void ChorusReference::setChannelPhaseOffsets (const float* cycles, int count)
+{
+    for (size_t channel = 0; channel < channelPhase.size(); ++channel)
+        channelPhase[channel] = static_cast<int> (channel) < count ? cycles[channel] : 0.0;
+}
+
+void ChorusReference::setTargets (const ChorusEngine::Parameters& params)
+{
+    const int requestedVoices = std::min (std::max (params.voices, 1), ChorusEngine::maxVoices);
+
+    if (! started)
+    {
+        started = true;
+        rateRamp.snap (params.rate);
+        depthRamp.snap (params.depth);
+        mixRamp.snap (params.mix);
+        switchRamp.snap (1.0f);
+        rate = params.rate;
+        voices = requestedVoices;
+        interpolation = params.interpolation;
+        switchPending = false;
+        return;
+    }
+
+    rateRamp.setTarget (params.rate);
+    depthRamp.setTarget (params.depth);
+    mixRamp.setTarget (params.mix);
+
+    // Estructura: bajar el wet a cero, cambiar y volver a subir
+    if (requestedVoices != voices || params.interpolation != interpolation)
+    {
+        pendingVoices = requestedVoices;
+        pendingInterpolation = params.interpolation;
+        switchPending = true;
+        switchRamp.setTarget (0.0f);
+    }
+    else if (switchPending)
+    {
+        switchPending = false;
+        switchRamp.setTarget (1.0f);
+    }
+}
+
+float& ChorusReference::getSmoothed (int channel, int numVoices, int voice)
+{
+    const int first = (numVoices - 1) * numVoices / 2;
+    return smoothed[(size_t) (channel * smoothersPerChannel + first + voice)];
+}
+
+void ChorusReference::process (float* const* channels, int numChannels, int numSamples, const ChorusEngine::Parameters& params)
+{
+    numChannels = std::min (numChannels, static_cast<int> (delayBuffers.size()));
+    setTargets (params);
+
+    for (int sample = 0; sample < numSamples; ++sample)
+    {
+        // RAMPAS - el rate solo cambia al empezar un paso del LFO
+        if (frameCount % ChorusLfo::stepFrames == 0 && rateRamp.isRamping())
+            rate = rateRamp.advance (ChorusLfo::stepFrames);
+
+        if (switchPending && ! switchRamp.isRamping())
+        {
+            if (pendingInterpolation == ChorusEngine::Interpolation::allpass && interpolation != ChorusEngine::Interpolation::allpass)
+                std::fill (allpassState.begin(), allpassState.end(), 0.0f);
+
+            voices = pendingVoices;
+            interpolation = pendingInterpolation;
+            switchPending = false;
+            switchRamp.setTarget (1.0f);
+        }
+
+        const float depth = depthRamp.advance (1);
+        const float mix = mixRamp.advance (1);
+        const float switchGain = switchRamp.advance (1);
+        ++frameCount;
+
+        // LFO UNA VEZ POR FRAME
+        phase = advancePhase (phase, rate, sampleRate);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            // Las demas cantidades de voces avanzan su suavizado; solo se leen las de la estructura en uso
+            for (int count = 1; smoothAllVoiceCounts && count <= ChorusEngine::maxVoices; ++count)
+                if (count != voices)
+                    for (int v = 0; v < count; ++v)
+                        smoothLfo (getSmoothed (channel, count, v), phase + static_cast<double> (v) / count + channelPhase[(size_t) channel]);
+
+            float delaySamples[ChorusEngine::maxVoices];
+            for (int v = 0; v < voices; ++v)
+            {
+                const double voicePhase = phase + static_cast<double> (v) / voices + channelPhase[(size_t) channel];
+                const float lfoValue = smoothLfo (getSmoothed (channel, voices, v), voicePhase);
+
+                // RANGO 15-22ms con la curva depth^2
+                const float delayTimeMs = 15.0f + 7.0f * (depth * depth) * lfoValue;
+                delaySamples[v] = std::min (std::max (delayTimeMs * static_cast<float> (sampleRate) / 1000.0f, 10.0f),
+                                            static_cast<float> (size - 10));
+            }
+
+            auto& delayData = delayBuffers[(size_t) channel];
+            const float inputSample = channels[channel][sample];
+
+            delayData[(size_t) writePosition] = inputSample * 0.999f;
+
+            float delayed = 0.0f;
+            for (int v = 0; v < voices; ++v)
+            {
+                double readPosition = writePosition - static_cast<double> (delaySamples[v]);
+                while (readPosition < 0.0)
+                    readPosition += size;
+
+                const int idx1 = static_cast<int> (readPosition);
+                const float frac = static_cast<float> (readPosition - idx1);
+
+                // Ventana idx1-2 .. idx1+3 con envoltura explicita
+                float window[6];
+                for (int k = 0; k < 6; ++k)
+                    window[k] = delayData[(size_t) ((idx1 - 2 + k + size) % size)];
+
+                delayed += interpolate (interpolation, window + 2, frac,
+                                        allpassState[(size_t) (channel * ChorusEngine::maxVoices + v)]);
+            }
+
+            const float outputSample = inputSample * (1.0f - mix) + delayed * wetGain (depth, mix, voices) * switchGain;
+            channels[channel][sample] = softClip (outputSample);
+        }
+
+        writePosition = (writePosition + 1) % size;
+    }
+}
+
+void ChorusReference::Ramp::setTarget (float newTarget)
+{
+    if (newTarget == target)
+        return;
+
+    start = getValue();
+    target = newTarget;
+    elapsed = 0;
+}
+
+float ChorusReference::Ramp::getValue() const
+{
+    if (elapsed >= length)
+        return target;
+
+    const double position = static_cast<double> (elapsed) / length;
+    if (exponential && start > 0.0f && target > 0.0f)
+        return static_cast<float> (start * std::pow (static_cast<double> (target) / start, position));
+
+    return static_cast<float> (start + (static_cast<double> (target) - start) * position);
+}
+
+float ChorusReference::Ramp::advance (int numSamples)
+{
+    elapsed = std::min (elapsed + numSamples, length);
+    return getValue();
+}
+
+float ChorusReference::interpolate (ChorusEngine::Interpolation interpolation, const float* y, float frac, float& state)
+{
+    switch (interpolation)
+    {
+        case ChorusEngine::Interpolation::linear:
+            return y[0] + (y[1] - y[0]) * frac;
+
+        case ChorusEngine::Interpolation::lagrange:
+        {
+            // Lagrange de 6 puntos sobre los nodos -2..3
+            float sum = 0.0f;
+            for (int k = -2; k <= 3; ++k)
+            {
+                float weight = 1.0f;
+                for (int j = -2; j <= 3; ++j)
+                    if (j != k)
+                        weight *= (frac - static_cast<float> (j)) / static_cast<float> (k - j);
+
+                sum += weight * y[k];
+            }
+            return sum;
+        }
+
+        case ChorusEngine::Interpolation::allpass:
+        {
+            // Allpass de primer orden; retardo fraccional respecto a y[1] de 1 - frac
+            const float eta = 1.0f - frac;
+            const float a = (1.0f - eta) / (1.0f + eta);
+            state = y[0] + a * (y[1] - state);
+            return state;
+        }
+
+        case ChorusEngine::Interpolation::catmullRom:
+        default:
+        {
+            // Coeficientes Catmull-Rom, como en el original
+            const float c0 = y[0];
+            const float c1 = 0.5f * (y[1] - y[-1]);
+            const float c2 = y[-1] - 2.5f * y[0] + 2.0f * y[1] - 0.5f * y[2];
+            const float c3 = 0.5f * (y[2] - y[-1]) + 1.5f * (y[0] - y[1]);
+            return c0 + c1 * frac + c2 * frac * frac + c3 * frac * frac * frac;
+        }
+    }
+}
+
+float ChorusReference::wetGain (float depth, float mix, int voices)
+{
+    // SUAVIZADO ADAPTATIVO
+    float adaptiveSmoothing = 1.0f;
+    if (depth > 0.3f)
+    {
+        const float depthFactor = (depth - 0.3f) / 0.7f;
+        adaptiveSmoothing = 1.0f - depthFactor * 0.2f;
+    }
+
+    return adaptiveSmoothing * mix * 0.95f / static_cast<float> (voices);
+}
+
+float ChorusReference::softClip (float sample)
+{
+    const float threshold = 0.99f;
+    if (sample > threshold)
+        return threshold + (sample - threshold) * 0.3f;
+    if (sample < -threshold)
+        return -threshold + (sample + threshold) * 0.3f;
+    return sample;
+}
+
+double ChorusReference::advancePhase (double currentPhase, float rate, double currentSampleRate)
+{
+    currentPhase += rate / currentSampleRate;
+    return currentPhase - std::floor (currentPhase);
+}
+
+float ChorusReference::smoothLfo (float& smoothedValue, double lfoPhase)
+{
+    const float lfoValue = 0.5f + 0.5f * static_cast<float> (std::sin (twoPi * lfoPhase));
+    smoothedValue = 0.9995f * smoothedValue + 0.0005f * lfoValue;
+    return smoothedValue;
+}
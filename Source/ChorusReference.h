@@ -0,0 +1,97 @@
+#pragma once
+
+#include "ChorusEngine.h"
+#include <vector>
+
+// Referencia escalar congelada de Koruz: el bucle del processBlock original,
+// muestra a muestra y canal a canal, sin SIMD y sin planes por bloque. No se
+// optimiza nunca; es la vara de medir de KoruzBenchmark --verify para
+// ChorusEngine, ChorusBatch y los interpoladores.
+//
+// Solo se aparta del original donde el motor lo hace a proposito:
+// - el LFO avanza una vez por frame, compartido por todos los canales (el
+//   original lo avanzaba una vez por canal);
+// - delay line de potencia de dos y posicion de lectura en double (el original
+//   perdia precision en float con writePos grandes);
+// - voces (desfase v / voces, wet repartido entre ellas) e interpolaciones
+//   distintas de Catmull-Rom, escritas en su forma de libro;
+// - desfase del LFO por canal (surround), con un suavizado por canal y voz;
+// - rampas de parametros (el original no tenia), en su forma de libro y no como
+//   las acumula el motor: depth y mix lineales en rampTimeSeconds, rate
+//   exponencial tomado en cada paso de ChorusLfo::stepFrames, y voces o
+//   interpolacion con el wet a cero en switchFadeSeconds, el cambio y vuelta a
+//   subir. Para que un cambio de voces no arrastre historia, el suavizado del LFO
+//   se puede llevar para todas las cantidades de voces a la vez.
+class ChorusReference
+{
+public:
+    void prepare (double sampleRate, int numChannels);
+    void reset();
+
+    // Mismo significado que ChorusEngine::setChannelPhaseOffsets
+    void setChannelPhaseOffsets (const float* cycles, int count);
+
+    // Suavizar el LFO de todas las cantidades de voces y no solo la de la estructura
+    // en uso; necesario si cambian las voces (mucho mas lento)
+    void setSmoothAllVoiceCounts (bool shouldSmoothAll) { smoothAllVoiceCounts = shouldSmoothAll; }
+
+    // params es el objetivo desde el principio del bloque, como setParameters en el
+    // motor; la primera llamada tras reset arranca en el, sin rampa
+    void process (float* const* channels, int numChannels, int numSamples, const ChorusEngine::Parameters& params);
+
+    // KERNELS - cada uno es el paso equivalente de un camino optimizado
+
+    // Lectura en y[0] + frac hacia y[1]; y debe ser valido de y[-2] a y[3].
+    // allpassState es la salida anterior de esa voz (solo la usa el allpass)
+    static float interpolate (ChorusEngine::Interpolation interpolation, const float* y, float frac, float& allpassState);
+
+    // Ganancia wet por voz (mix * 0.95 con el suavizado adaptativo por depth)
+    static float wetGain (float depth, float mix, int voices);
+
+    // Rodilla de 0.99 con pendiente 0.3
+    static float softClip (float sample);
+
+    // LFO: la fase avanza primero y despues cada voz suaviza su seno (0.9995)
+    static double advancePhase (double phase, float rate, double sampleRate);
+    static float smoothLfo (float& smoothed, double phase);
+
+private:
+    // valor (k) = inicio + (objetivo - inicio) * k / length, o inicio * (objetivo / inicio)^(k / length)
+    struct Ramp
+    {
+        float start = 0.0f;
+        float target = 0.0f;
+        int elapsed = 0;
+        int length = 1;
+        bool exponential = false;
+
+        void snap (float value) { start = target = value; elapsed = length; }
+        void setTarget (float newTarget);
+        bool isRamping() const { return elapsed < length; }
+        float getValue() const;
+        float advance (int numSamples);
+    };
+
+    void setTargets (const ChorusEngine::Parameters& params);
+    float& getSmoothed (int channel, int voices, int voice);
+
+    double sampleRate = 44100.0;
+    int size = 0;
+    int writePosition = 0;
+    double phase = 0.0;
+    std::vector<std::vector<float>> delayBuffers;
+    std::vector<double> channelPhase;
+    std::vector<float> smoothed;       // [canal][voces - 1][voz]
+    std::vector<float> allpassState;   // [canal][voz]
+
+    bool smoothAllVoiceCounts = false;
+    bool started = false;
+    long long frameCount = 0;          // para la rejilla del LFO
+    Ramp rateRamp, depthRamp, mixRamp, switchRamp;
+    float rate = 0.0f;                 // rate del paso del LFO en curso
+    int voices = 1;                    // estructura en uso
+    ChorusEngine::Interpolation interpolation = ChorusEngine::Interpolation::catmullRom;
+    int pendingVoices = 1;
+    ChorusEngine::Interpolation pendingInterpolation = ChorusEngine::Interpolation::catmullRom;
+    bool switchPending = false;
+};
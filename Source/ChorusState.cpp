@@ -0,0 +1,214 @@
+#include "ChorusState.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    constexpr std::uint8_t magic[4] = { 'K', 'R', 'Z', 'S' };
+    constexpr std::size_t headerSize = 8;
+    constexpr std::size_t fieldHeaderSize = 4;
+
+    void writeU16 (std::uint8_t* dest, std::uint16_t value)
+    {
+        dest[0] = static_cast<std::uint8_t> (value);
+        dest[1] = static_cast<std::uint8_t> (value >> 8);
+    }
+
+    void writeU32 (std::uint8_t* dest, std::uint32_t value)
+    {
+        for (int i = 0; i < 4; ++i)
+            dest[i] = static_cast<std::uint8_t> (value >> (8 * i));
+    }
+
+    void writeU64 (std::uint8_t* dest, std::uint64_t value)
+    {
+        for (int i = 0; i < 8; ++i)
+            dest[i] = static_cast<std::uint8_t> (value >> (8 * i));
+    }
+
+    std::uint16_t readU16 (const std::uint8_t* src)
+    {
+        return static_cast<std::uint16_t> (src[0] | (src[1] << 8));
+    }
+
+    std::uint32_t readU32 (const std::uint8_t* src)
+    {
+        std::uint32_t value = 0;
+        for (int i = 0; i < 4; ++i)
+            value |= static_cast<std::uint32_t> (src[i]) << (8 * i);
+        return value;
+    }
+
+    std::uint64_t readU64 (const std::uint8_t* src)
+    {
+        std::uint64_t value = 0;
+        for (int i = 0; i < 8; ++i)
+            value |= static_cast<std::uint64_t> (src[i]) << (8 * i);
+        return value;
+    }
+
+    // Escritor secuencial de campos sobre un buffer fijo
+    struct FieldWriter
+    {
+        std::uint8_t* dest;
+        std::size_t capacity;
+        std::size_t position = headerSize;
+        std::uint16_t numFields = 0;
+        bool overflow = false;
+
+        std::uint8_t* beginField (std::uint16_t id, std::uint16_t bytes)
+        {
+            if (position + fieldHeaderSize + bytes > capacity)
+            {
+                overflow = true;
+                return nullptr;
+            }
+
+            writeU16 (dest + position, id);
+            writeU16 (dest + position + 2, bytes);
+            std::uint8_t* payload = dest + position + fieldHeaderSize;
+            position += fieldHeaderSize + bytes;
+            ++numFields;
+            return payload;
+        }
+
+        void addFloat (std::uint16_t id, float value)
+        {
+            std::uint32_t bits;
+            std::memcpy (&bits, &value, sizeof (bits));
+            if (auto* payload = beginField (id, 4))
+                writeU32 (payload, bits);
+        }
+
+        void addInt (std::uint16_t id, std::int32_t value)
+        {
+            if (auto* payload = beginField (id, 4))
+                writeU32 (payload, static_cast<std::uint32_t> (value));
+        }
+
+        void addDouble (std::uint16_t id, double value)
+        {
+            std::uint64_t bits;
+            std::memcpy (&bits, &value, sizeof (bits));
+            if (auto* payload = beginField (id, 8))
+                writeU64 (payload, bits);
+        }
+    };
+
+    float toFloat (const std::uint8_t* payload)
+    {
+        const std::uint32_t bits = readU32 (payload);
+        float value;
+        std::memcpy (&value, &bits, sizeof (value));
+        return value;
+    }
+
+    double toDouble (const std::uint8_t* payload)
+    {
+        const std::uint64_t bits = readU64 (payload);
+        double value;
+        std::memcpy (&value, &bits, sizeof (value));
+        return value;
+    }
+}
+
+std::size_t ChorusState::write (std::uint8_t* dest, std::size_t capacity) const
+{
+    if (dest == nullptr || capacity < headerSize)
+        return 0;
+
+    FieldWriter writer { dest, capacity };
+    writer.addFloat (rateField, parameters.rate);
+    writer.addFloat (depthField, parameters.depth);
+    writer.addFloat (mixField, parameters.mix);
+    writer.addInt (voicesField, parameters.voices);
+    writer.addInt (interpolationField, static_cast<std::int32_t> (parameters.interpolation));
+    writer.addInt (clipOversamplingField, clipOversampling ? 1 : 0);
+    writer.addInt (cpuGovernorField, cpuGovernor ? 1 : 0);
+
+    if (hasLfoPhase)
+        writer.addDouble (lfoPhaseField, lfoPhase);
+
+    if (writer.overflow)
+        return 0;
+
+    std::memcpy (dest, magic, sizeof (magic));
+    writeU16 (dest + 4, version);
+    writeU16 (dest + 6, writer.numFields);
+    return writer.position;
+}
+
+bool ChorusState::read (const void* data, std::size_t size)
+{
+    const auto* bytes = static_cast<const std::uint8_t*> (data);
+
+    if (bytes == nullptr || size < headerSize || std::memcmp (bytes, magic, sizeof (magic)) != 0)
+        return false;
+
+    // La version solo informa; la compatibilidad la dan los ids de campo
+    const std::uint16_t numFields = readU16 (bytes + 6);
+
+    // Primero se valida todo sobre una copia para no dejar un estado a medias
+    ChorusState loaded = *this;
+    loaded.hasLfoPhase = false;
+    std::size_t position = headerSize;
+
+    for (std::uint16_t f = 0; f < numFields; ++f)
+    {
+        if (position + fieldHeaderSize > size)
+            return false;
+
+        const std::uint16_t id = readU16 (bytes + position);
+        const std::uint16_t fieldSize = readU16 (bytes + position + 2);
+        const std::uint8_t* payload = bytes + position + fieldHeaderSize;
+
+        if (position + fieldHeaderSize + fieldSize > size)
+            return false;
+
+        position += fieldHeaderSize + fieldSize;
+
+        // Un campo conocido con otro tamano se trata como desconocido
+        switch (id)
+        {
+            case rateField:     if (fieldSize == 4) loaded.parameters.rate = toFloat (payload); break;
+            case depthField:    if (fieldSize == 4) loaded.parameters.depth = toFloat (payload); break;
+            case mixField:      if (fieldSize == 4) loaded.parameters.mix = toFloat (payload); break;
+            case voicesField:   if (fieldSize == 4) loaded.parameters.voices = static_cast<std::int32_t> (readU32 (payload)); break;
+            case lfoPhaseField: if (fieldSize == 8) { loaded.lfoPhase = toDouble (payload); loaded.hasLfoPhase = true; } break;
+            case interpolationField:
+                if (fieldSize == 4)
+                {
+                    const auto value = static_cast<std::int32_t> (readU32 (payload));
+                    if (value >= 0 && value <= static_cast<std::int32_t> (ChorusEngine::Interpolation::allpass))
+                        loaded.parameters.interpolation = static_cast<ChorusEngine::Interpolation> (value);
+                }
+                break;
+            case clipOversamplingField: if (fieldSize == 4) loaded.clipOversampling = readU32 (payload) != 0; break;
+            case cpuGovernorField:      if (fieldSize == 4) loaded.cpuGovernor = readU32 (payload) != 0; break;
+            default:            break;
+        }
+    }
+
+    // VALIDACION - nada no finito; el resto a los rangos de los parametros
+    auto& params = loaded.parameters;
+
+    if (! std::isfinite (params.rate) || ! std::isfinite (params.depth) || ! std::isfinite (params.mix)
+         || (loaded.hasLfoPhase && ! std::isfinite (loaded.lfoPhase)))
+        return false;
+
+    params.rate = std::min (std::max (params.rate, minRate), maxRate);
+    params.depth = std::min (std::max (params.depth, 0.0f), 1.0f);
+    params.mix = std::min (std::max (params.mix, 0.0f), 1.0f);
+    params.voices = std::min (std::max (params.voices, 1), ChorusEngine::maxVoices);
+
+    if (loaded.hasLfoPhase)
+    {
+        loaded.lfoPhase -= std::floor (loaded.lfoPhase);
+        if (loaded.lfoPhase >= 1.0)   // -1e-20 - floor da 1.0 exacto
+            loaded.lfoPhase = 0.0;
+    }
+
+    *this = loaded;
+    return true;
+}
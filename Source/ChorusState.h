@@ -0,0 +1,54 @@
+#pragma once
+
+#include "ChorusEngine.h"
+#include <cstddef>
+#include <cstdint>
+
+// Estado binario compacto de Koruz (independiente de JUCE).
+//
+//   cabecera:  "KRZS" | version u16 | numCampos u16
+//   campo:     id u16 | bytes u16 | datos
+//
+// Todo en little-endian. Al leer, los campos desconocidos se saltan (estados de
+// versiones nuevas) y los que faltan conservan su valor por defecto (estados
+// antiguos). Un valor no finito invalida el estado; el resto se lleva a los
+// rangos de los parametros y la fase del LFO a [0, 1), asi que un estado corrupto
+// o de otro plugin nunca llega al motor como NaN. Ni la escritura ni la lectura
+// reservan memoria.
+struct ChorusState
+{
+    static constexpr std::uint16_t version = 1;
+
+    // Ids de campo: no reutilizar ni renumerar, solo anadir al final
+    enum FieldId : std::uint16_t
+    {
+        rateField     = 1,   // f32, Hz
+        depthField    = 2,   // f32, 0..1
+        mixField      = 3,   // f32, 0..1
+        voicesField   = 4,   // i32
+        lfoPhaseField = 5,   // f64, ciclos (opcional)
+        interpolationField = 6,  // i32, ChorusEngine::Interpolation
+        clipOversamplingField = 7,  // i32, 0/1: rodilla a 2x
+        cpuGovernorField = 8        // i32, 0/1: gobernador de CPU (solo el VST3)
+    };
+
+    // Rangos de los parametros (los mismos en el VST3 y en el CLAP)
+    static constexpr float minRate = 0.1f;   // Hz
+    static constexpr float maxRate = 2.0f;
+
+    // Tamano maximo que ocupa un estado escrito por esta version
+    static constexpr std::size_t maxSize = 8 + 3 * (4 + 4) + (4 + 4) + (4 + 8) + (4 + 4) + (4 + 4) + (4 + 4);
+
+    ChorusEngine::Parameters parameters;
+    bool clipOversampling = false;
+    bool cpuGovernor = false;
+    bool hasLfoPhase = false;
+    double lfoPhase = 0.0;
+
+    // Devuelve los bytes escritos, o 0 si no caben en capacity
+    std::size_t write (std::uint8_t* dest, std::size_t capacity) const;
+
+    // Devuelve false si no es un estado de Koruz, esta truncado o trae valores no
+    // finitos; en ese caso no se toca nada
+    bool read (const void* data, std::size_t size);
+};
@@ -0,0 +1,780 @@
+#include "ChorusVerify.h"
+#include "ChorusBatch.h"
+#include "ChorusEngine.h"
+#include "ChorusLfo.h"
+#include "ChorusReference.h"
+#include "Interpolators.h"
+#include "SimdVec.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr double twoPi = 6.283185307179586476925286766559;
+
+    using Interpolation = ChorusEngine::Interpolation;
+
+    // TOLERANCIAS - error absoluto maximo por kernel. Las de extremo a extremo
+    // vienen sobre todo del suavizado del LFO en float (el motor suaviza seno y
+    // coseno y la referencia cada voz, ~3e-5 de diferencia en el LFO), que crece
+    // con el sample rate; por eso se miden con senal tonal y se escalan por
+    // sampleRate / 48000. Los coeficientes se comprueban aparte, lectura a lectura.
+    constexpr double kernelTolerance = 1.0e-5;      // interpoladores, una lectura
+    constexpr double allpassTolerance = 1.0e-5;     // allpass, secuencia con estado
+    constexpr double lfoTolerance = 1.0e-4;         // LFO suavizado, valor 0..1
+    constexpr double softClipTolerance = 1.0e-6;    // dry + rodilla (mix 0)
+    constexpr double engineTolerance = 2.0e-3;      // motor completo a 48 kHz, senal tonal
+    constexpr double allpassEngineTolerance = 6.0e-3;   // transitorios al cruzar el entero del delay
+    constexpr double idleTolerance = 3.0e-3;        // reanudar tras reposo
+    constexpr double automationTolerance = 2.0e-3;  // rampas acumuladas en float frente a las de libro
+    constexpr double batchTolerance = 1.0e-3;       // ChorusBatch (LFO rotado en float)
+    constexpr double oversampledKneeTolerance = 0.05;  // rodilla a 2x frente a la de 1x (sin sus armonicos altos)
+    constexpr double aliasRatioTolerance = 0.25;    // potencia de alias a 2x / a 1x (-6 dB)
+
+    const char* getName (Interpolation interpolation)
+    {
+        switch (interpolation)
+        {
+            case Interpolation::linear:     return "linear";
+            case Interpolation::lagrange:   return "lagrange";
+            case Interpolation::allpass:    return "allpass";
+            case Interpolation::catmullRom:
+            default:                        return "catmull_rom";
+        }
+    }
+
+    class Report
+    {
+    public:
+        explicit Report (bool jsonOutput) : json (jsonOutput)
+        {
+            if (! json)
+                std::printf ("kernel,config,max_error,tolerance,result\n");
+        }
+
+        void add (const std::string& kernel, const std::string& config, double maxError, double tolerance)
+        {
+            const bool passed = maxError <= tolerance;
+            failures += passed ? 0 : 1;
+
+            if (json)
+                std::printf ("{\"kernel\":\"%s\",\"config\":\"%s\",\"max_error\":%.3g,\"tolerance\":%.3g,\"result\":\"%s\"}\n",
+                             kernel.c_str(), config.c_str(), maxError, tolerance, passed ? "ok" : "FAILED");
+            else
+                std::printf ("%s,%s,%.3g,%.3g,%s\n", kernel.c_str(), config.c_str(), maxError, tolerance, passed ? "ok" : "FAILED");
+
+            std::fflush (stdout);
+        }
+
+        int getFailures() const { return failures; }
+
+    private:
+        bool json;
+        int failures = 0;
+    };
+
+    //==============================================================================
+    // Interpoladores: coeficientes del plan + lectura SIMD frente a la formula escalar
+    template <typename Interp, typename Vec>
+    double measureInterpolator (Interpolation interpolation, int numReads)
+    {
+        constexpr int W = Vec::width;
+        std::mt19937 rng (17);
+        std::uniform_real_distribution<float> sampleDist (-1.0f, 1.0f);
+        std::uniform_real_distribution<float> fracDist (0.0f, 1.0f);
+
+        alignas (32) float window[8 * W];
+        alignas (32) float weights[ChorusEngine::maxTaps * W];
+        alignas (32) float tValues[W];
+        float scalarWindow[8];
+
+        float referenceState[W] = {};
+        double maxError = 0.0;
+
+        for (int n = 0; n < numReads; ++n)
+        {
+            // Una fraccion por carril; en el motor es una por voz, el kernel es el mismo
+            for (int lane = 0; lane < W; ++lane)
+                tValues[lane] = n == 0 ? 1.0f : fracDist (rng);
+
+            for (int i = 0; i < 8 * W; ++i)
+                window[i] = sampleDist (rng);
+
+            // La ventana del motor empieza en idx1 + firstTap y t = 1 - frac (t va del mas nuevo al mas viejo)
+            Interp::computeWeights (Vec::load (tValues), weights, W);
+
+            for (int lane = 0; lane < W; ++lane)
+            {
+                alignas (32) float laneWeights[ChorusEngine::maxTaps * W];
+                for (int tap = 0; tap < Interp::numTaps; ++tap)
+                    for (int k = 0; k < W; ++k)
+                        laneWeights[tap * W + k] = weights[tap * W + lane];
+
+                alignas (32) float laneOutput[W];
+                auto lanePrevious = Vec::broadcast (referenceState[lane]);
+                Interp::read (window, laneWeights, W, lanePrevious).store (laneOutput);
+
+                // Referencia: y[0] es el frame idx1 (el de firstTap = 0 en la ventana)
+                for (int k = 0; k < 8; ++k)
+                    scalarWindow[k] = window[k * W + lane];
+
+                float state = referenceState[lane];
+                const float expected = ChorusReference::interpolate (interpolation, scalarWindow - Interp::firstTap, tValues[lane], state);
+                referenceState[lane] = state;
+
+                maxError = std::max (maxError, static_cast<double> (std::abs (laneOutput[lane] - expected)));
+            }
+        }
+
+        return maxError;
+    }
+
+    //==============================================================================
+    // Senal tonal (220 Hz + 1370 Hz) con un tramo de silencio opcional en medio
+    std::vector<std::vector<float>> makeSignal (int numChannels, int numSamples, double sampleRate, float level, bool withGap)
+    {
+        std::vector<std::vector<float>> signal (static_cast<size_t> (numChannels), std::vector<float> (static_cast<size_t> (numSamples)));
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const double t = i / sampleRate;
+                const bool silent = withGap && i >= numSamples / 3 && i < numSamples / 2;
+                signal[(size_t) ch][(size_t) i] = silent ? 0.0f
+                    : level * static_cast<float> (0.6 * std::sin (twoPi * 220.0 * t + ch) + 0.4 * std::sin (twoPi * 1370.0 * t + 2 * ch));
+            }
+
+        return signal;
+    }
+
+    // Automatizacion: parametros nuevos desde frame
+    struct ParameterChange
+    {
+        int frame = 0;
+        ChorusEngine::Parameters parameters;
+    };
+
+    // Rate, depth y mix nuevos cada interval frames (interval impar: a mitad de bloque);
+    // con changeStructure, uno de cada dos cambios trae ademas voces e interpolacion
+    // de las calidades del plugin
+    std::vector<ParameterChange> makeAutomation (const ChorusEngine::Parameters& base, int numSamples, int interval,
+                                                 bool changeStructure = false)
+    {
+        const Interpolation qualities[] = { Interpolation::linear, Interpolation::catmullRom, Interpolation::lagrange };
+
+        std::mt19937 rng (23);
+        std::uniform_real_distribution<float> unit (0.0f, 1.0f);
+        std::vector<ParameterChange> changes;
+        auto parameters = base;
+
+        for (int frame = interval; frame < numSamples; frame += interval)
+        {
+            parameters.rate = 0.1f + 1.9f * unit (rng);
+            parameters.depth = unit (rng);
+            parameters.mix = unit (rng);
+
+            if (changeStructure && changes.size() % 2 == 1)
+            {
+                parameters.voices = 1 + static_cast<int> (rng() % ChorusEngine::maxVoices);
+                parameters.interpolation = qualities[rng() % 3];
+            }
+
+            changes.push_back ({ frame, parameters });
+        }
+
+        return changes;
+    }
+
+    struct EngineRun
+    {
+        double sampleRate = 48000.0;
+        int blockSize = 480;
+        int numChannels = 2;
+        ChorusEngine::Parameters parameters;
+        float level = 0.5f;
+        bool withGap = false;
+        bool channelOffsets = false;   // desfase de LFO por canal (surround)
+        bool oversampledClip = true;   // rodilla a 2x (por defecto) o en el bucle
+        bool sharedWorkspace = true;   // con el pool lleno, memoria de trabajo propia (tramos cortos)
+        std::vector<ParameterChange> changes;   // el bloque se parte en cada cambio
+    };
+
+    // Recorre la senal en bloques de run.blockSize partidos en cada cambio de
+    // parametros, como un host con eventos sample-accurate:
+    // function (inicio, frames, parametros vigentes)
+    template <typename Function>
+    void forEachRange (const EngineRun& run, int numSamples, Function&& function)
+    {
+        auto parameters = run.parameters;
+        size_t nextChange = 0;
+
+        for (int offset = 0; offset < numSamples; offset += run.blockSize)
+        {
+            const int end = std::min (offset + run.blockSize, numSamples);
+
+            for (int start = offset; start < end;)
+            {
+                while (nextChange < run.changes.size() && run.changes[nextChange].frame <= start)
+                    parameters = run.changes[nextChange++].parameters;
+
+                const int stop = nextChange < run.changes.size() ? std::min (end, run.changes[nextChange].frame) : end;
+                function (start, stop - start, parameters);
+                start = stop;
+            }
+        }
+    }
+
+    std::string describe (const EngineRun& run)
+    {
+        char text[224];
+        std::snprintf (text, sizeof (text), "sr=%.0f block=%d ch=%d%s voices=%d rate=%.2f depth=%.2f mix=%.2f%s%s%s",
+                       run.sampleRate, run.blockSize, run.numChannels, run.channelOffsets ? " offsets" : "",
+                       run.parameters.voices, run.parameters.rate, run.parameters.depth, run.parameters.mix,
+                       run.oversampledClip ? "" : " clip=1x", run.sharedWorkspace ? "" : " workspace=own",
+                       run.changes.empty() ? "" : " automated");
+        return text;
+    }
+
+    // Mismo reparto que el plugin (proporcion aurea)
+    void getChannelOffsets (float* offsets)
+    {
+        for (int ch = 0; ch < ChorusEngine::maxChannels; ++ch)
+            offsets[ch] = static_cast<float> (ch * 0.6180339887 - std::floor (ch * 0.6180339887));
+    }
+
+    // Motor en bloques de run.blockSize frente a la referencia en los mismos bloques,
+    // alineados por la latencia de la rodilla a 2x
+    template <typename SampleType>
+    double measureEngine (const EngineRun& run, double seconds)
+    {
+        const int numSamples = static_cast<int> (run.sampleRate * seconds);
+        const auto input = makeSignal (run.numChannels, numSamples, run.sampleRate, run.level, run.withGap);
+
+        std::vector<std::vector<SampleType>> processed (input.size());
+        for (size_t ch = 0; ch < input.size(); ++ch)
+            processed[ch].assign (input[ch].begin(), input[ch].end());
+
+        auto expected = input;
+
+        ChorusEngine engine;
+        engine.setParameters (run.parameters);
+        engine.setClipOversampling (run.oversampledClip);
+        engine.prepare (run.sampleRate, run.numChannels, run.blockSize);
+
+        ChorusReference reference;
+        reference.prepare (run.sampleRate, run.numChannels);
+        reference.setSmoothAllVoiceCounts (std::any_of (run.changes.begin(), run.changes.end(), [&] (const ParameterChange& change)
+        {
+            return change.parameters.voices != run.parameters.voices;
+        }));
+
+        if (run.channelOffsets)
+        {
+            float offsets[ChorusEngine::maxChannels];
+            getChannelOffsets (offsets);
+            engine.setChannelPhaseOffsets (offsets, run.numChannels);
+            reference.setChannelPhaseOffsets (offsets, run.numChannels);
+        }
+
+        std::vector<SampleType*> enginePointers (input.size());
+        std::vector<float*> referencePointers (input.size());
+
+        // Pool ocupado: se toman todos los huecos antes de procesar
+        auto pool = ChorusWorkspacePool::acquire();
+        std::vector<int> heldSlots;
+        if (! run.sharedWorkspace)
+            for (int slot = pool->tryLock(); slot >= 0; slot = pool->tryLock())
+                heldSlots.push_back (slot);
+
+        forEachRange (run, numSamples, [&] (int offset, int n, const ChorusEngine::Parameters& parameters)
+        {
+            for (size_t ch = 0; ch < input.size(); ++ch)
+            {
+                enginePointers[ch] = processed[ch].data() + offset;
+                referencePointers[ch] = expected[ch].data() + offset;
+            }
+
+            engine.setParameters (parameters);
+            engine.process (enginePointers.data(), run.numChannels, n);
+            reference.process (referencePointers.data(), run.numChannels, n, parameters);
+        });
+
+        for (int slot : heldSlots)
+            pool->unlock (slot);
+
+        const int latency = engine.getLatencySamples();
+
+        double maxError = 0.0;
+        for (size_t ch = 0; ch < input.size(); ++ch)
+            for (int i = 0; i + latency < numSamples; ++i)
+                maxError = std::max (maxError, std::abs (static_cast<double> (processed[ch][(size_t) (i + latency)]) - expected[ch][(size_t) i]));
+
+        return maxError;
+    }
+
+    // Salida del motor solo, en bloques de run.blockSize
+    std::vector<std::vector<float>> renderEngine (const EngineRun& run, double seconds)
+    {
+        const int numSamples = static_cast<int> (run.sampleRate * seconds);
+        auto processed = makeSignal (run.numChannels, numSamples, run.sampleRate, run.level, run.withGap);
+
+        ChorusEngine engine;
+        engine.setParameters (run.parameters);
+        engine.setClipOversampling (run.oversampledClip);
+        engine.prepare (run.sampleRate, run.numChannels, run.blockSize);
+
+        if (run.channelOffsets)
+        {
+            float offsets[ChorusEngine::maxChannels];
+            getChannelOffsets (offsets);
+            engine.setChannelPhaseOffsets (offsets, run.numChannels);
+        }
+
+        auto pool = ChorusWorkspacePool::acquire();
+        std::vector<int> heldSlots;
+        if (! run.sharedWorkspace)
+            for (int slot = pool->tryLock(); slot >= 0; slot = pool->tryLock())
+                heldSlots.push_back (slot);
+
+        std::vector<float*> pointers (processed.size());
+        forEachRange (run, numSamples, [&] (int offset, int n, const ChorusEngine::Parameters& parameters)
+        {
+            for (size_t ch = 0; ch < processed.size(); ++ch)
+                pointers[ch] = processed[ch].data() + offset;
+
+            engine.setParameters (parameters);
+            engine.process (pointers.data(), run.numChannels, n);
+        });
+
+        for (int slot : heldSlots)
+            pool->unlock (slot);
+
+        return processed;
+    }
+
+    double getMaxDifference (const std::vector<std::vector<float>>& a, const std::vector<std::vector<float>>& b)
+    {
+        double maxError = 0.0;
+        for (size_t ch = 0; ch < a.size(); ++ch)
+            for (size_t i = 0; i < a[ch].size(); ++i)
+                maxError = std::max (maxError, std::abs (static_cast<double> (a[ch][i]) - b[ch][i]));
+
+        return maxError;
+    }
+
+    // Potencia de alias de la rodilla sobre un seno de fs * 7/48 (7 kHz a 48 kHz).
+    // La salida es periodica en 48 muestras: su DFT de 48 puntos es exacta, los
+    // armonicos caen en los bins 7, 14 y 21 y todo lo demas es alias
+    double measureAliasPower (bool oversampledClip)
+    {
+        constexpr int period = 48;
+        const int numSamples = 100 * period;
+
+        std::vector<float> signal (static_cast<size_t> (numSamples));
+        for (int i = 0; i < numSamples; ++i)
+            signal[(size_t) i] = 1.8f * static_cast<float> (std::sin (twoPi * 7.0 * (i % period) / period));
+
+        ChorusEngine::Parameters parameters;
+        parameters.mix = 0.0f;
+
+        ChorusEngine engine;
+        engine.setParameters (parameters);
+        engine.setClipOversampling (oversampledClip);
+        engine.prepare (48000.0, 1, 480);
+
+        for (int offset = 0; offset < numSamples; offset += 480)
+        {
+            float* channel = signal.data() + offset;
+            engine.process (&channel, 1, std::min (480, numSamples - offset));
+        }
+
+        const float* steady = signal.data() + numSamples - period;
+        double aliasPower = 0.0;
+
+        for (int bin = 1; bin <= period / 2; ++bin)
+        {
+            if (bin % 7 == 0)
+                continue;
+
+            double re = 0.0, im = 0.0;
+            for (int i = 0; i < period; ++i)
+            {
+                re += steady[i] * std::cos (twoPi * bin * i / period);
+                im += steady[i] * std::sin (twoPi * bin * i / period);
+            }
+
+            aliasPower += re * re + im * im;
+        }
+
+        return aliasPower;
+    }
+
+    //==============================================================================
+    void verifyInterpolators (Report& report, bool quick)
+    {
+        const int numReads = quick ? 2000 : 20000;
+
+        report.add ("interp_linear", "Float4", measureInterpolator<LinearInterpolator, Float4> (Interpolation::linear, numReads), kernelTolerance);
+        report.add ("interp_linear", "Float8", measureInterpolator<LinearInterpolator, Float8> (Interpolation::linear, numReads), kernelTolerance);
+        report.add ("interp_catmull_rom", "Float4", measureInterpolator<CatmullRomInterpolator, Float4> (Interpolation::catmullRom, numReads), kernelTolerance);
+        report.add ("interp_catmull_rom", "Float8", measureInterpolator<CatmullRomInterpolator, Float8> (Interpolation::catmullRom, numReads), kernelTolerance);
+        report.add ("interp_lagrange", "Float4", measureInterpolator<LagrangeInterpolator, Float4> (Interpolation::lagrange, numReads), kernelTolerance);
+        report.add ("interp_lagrange", "Float8", measureInterpolator<LagrangeInterpolator, Float8> (Interpolation::lagrange, numReads), kernelTolerance);
+        report.add ("interp_allpass", "Float4", measureInterpolator<AllpassInterpolator, Float4> (Interpolation::allpass, numReads), allpassTolerance);
+        report.add ("interp_allpass", "Float8", measureInterpolator<AllpassInterpolator, Float8> (Interpolation::allpass, numReads), allpassTolerance);
+    }
+
+    // LFO por tramos (como en el motor) y con avance en forma cerrada; el avance
+    // tiene que dejar el mismo estado, bit a bit, que procesar los mismos frames
+    void verifyLfo (Report& report, bool quick)
+    {
+        const double seconds = quick ? 2.0 : 10.0;
+
+        for (double sampleRate : { 44100.0, 192000.0 })
+            for (float rate : { 0.1f, 0.8f, 2.0f })
+                for (bool withAdvance : { false, true })
+                {
+                    ChorusLfo lfo, processed;
+                    lfo.prepare (sampleRate);
+                    lfo.setRate (rate);
+                    processed.prepare (sampleRate);
+                    processed.setRate (rate);
+
+                    double phase = 0.0;
+                    float smoothed = 0.5f;
+
+                    std::mt19937 rng (5);
+                    std::uniform_int_distribution<int> chunkDist (1, ChorusEngine::maxChunkFrames);
+                    std::vector<float> lfoSin (ChorusEngine::maxChunkFrames), lfoCos (ChorusEngine::maxChunkFrames);
+                    std::vector<float> processedSin (ChorusEngine::maxChunkFrames), processedCos (ChorusEngine::maxChunkFrames);
+
+                    const auto numSamples = static_cast<long long> (seconds * sampleRate);
+                    double maxError = 0.0;
+                    double maxMismatch = 0.0;
+
+                    for (long long position = 0; position < numSamples;)
+                    {
+                        const int n = chunkDist (rng);
+                        processed.process (processedSin.data(), processedCos.data(), n);
+
+                        if (withAdvance && (position / n) % 3 == 1)
+                        {
+                            lfo.advance (n);
+                            for (int i = 0; i < n; ++i)
+                            {
+                                phase = ChorusReference::advancePhase (phase, rate, sampleRate);
+                                ChorusReference::smoothLfo (smoothed, phase);
+                            }
+                        }
+                        else
+                        {
+                            lfo.process (lfoSin.data(), lfoCos.data(), n);
+                            for (int i = 0; i < n; ++i)
+                            {
+                                maxMismatch = std::max (maxMismatch, static_cast<double> (std::abs (lfoSin[(size_t) i] - processedSin[(size_t) i])));
+                                maxMismatch = std::max (maxMismatch, static_cast<double> (std::abs (lfoCos[(size_t) i] - processedCos[(size_t) i])));
+
+                                phase = ChorusReference::advancePhase (phase, rate, sampleRate);
+                                const float expected = ChorusReference::smoothLfo (smoothed, phase);
+                                maxError = std::max (maxError, static_cast<double> (std::abs (0.5f + 0.5f * lfoSin[(size_t) i] - expected)));
+                            }
+                        }
+
+                        position += n;
+                    }
+
+                    char config[96];
+                    std::snprintf (config, sizeof (config), "sr=%.0f rate=%.1f%s", sampleRate, rate, withAdvance ? " with advance" : "");
+                    report.add ("lfo", config, maxError, lfoTolerance);
+
+                    if (withAdvance)
+                        report.add ("lfo_advance", config, maxMismatch, 0.0);
+                }
+    }
+
+    void verifyEngine (Report& report, bool quick)
+    {
+        const double seconds = quick ? 0.25 : 1.0;
+
+        // Solo dry + rodilla: mix 0 y senal que pasa del umbral (rodilla en el bucle)
+        {
+            EngineRun run;
+            run.parameters.mix = 0.0f;
+            run.level = 1.6f;
+            run.oversampledClip = false;
+            report.add ("soft_clip", describe (run), measureEngine<float> (run, seconds), softClipTolerance);
+        }
+
+        // Rodilla con wet: depth y mix al maximo sobre senal fuerte
+        {
+            EngineRun run;
+            run.parameters.depth = 1.0f;
+            run.parameters.mix = 0.5f;
+            run.level = 1.6f;
+            run.oversampledClip = false;
+            report.add ("soft_clip_wet", describe (run), measureEngine<float> (run, seconds), engineTolerance);
+        }
+
+        // Rodilla a 2x por debajo del umbral (con y sin entrar en el camino sobremuestreado):
+        // solo retrasa, como la de 1x
+        for (float level : { 0.4f, 0.9f })
+        {
+            EngineRun run;
+            run.parameters.mix = 0.0f;
+            run.level = level;
+            report.add ("soft_clip_2x_linear", describe (run), measureEngine<float> (run, seconds), softClipTolerance);
+        }
+
+        // Sobre el umbral: cerca de la rodilla de 1x en senal grave, con mucho menos alias en aguda
+        for (int blockSize : { 1, 480 })
+        {
+            EngineRun run;
+            run.parameters.mix = 0.0f;
+            run.level = 1.6f;
+            run.blockSize = blockSize;
+            report.add ("soft_clip_2x", describe (run), measureEngine<float> (run, seconds), oversampledKneeTolerance);
+        }
+
+        report.add ("soft_clip_2x_alias", "sr=48000 f=7000 level=1.80", measureAliasPower (true) / measureAliasPower (false), aliasRatioTolerance);
+
+        // Ganancia wet: el suavizado adaptativo cambia de tramo en depth 0.3
+        for (float depth : { 0.0f, 0.3f, 0.31f, 0.65f, 1.0f })
+        {
+            EngineRun run;
+            run.parameters.depth = depth;
+            run.parameters.mix = 1.0f;
+            report.add ("wet_gain", describe (run), measureEngine<float> (run, seconds), engineTolerance);
+        }
+
+        const Interpolation interpolations[] = { Interpolation::linear, Interpolation::catmullRom,
+                                                 Interpolation::lagrange, Interpolation::allpass };
+
+        for (auto interpolation : interpolations)
+        {
+            const std::string kernel = std::string ("engine_") + getName (interpolation);
+            const double tolerance = interpolation == Interpolation::allpass ? allpassEngineTolerance : engineTolerance;
+
+            std::vector<EngineRun> runs;
+            EngineRun base;
+            base.parameters.rate = 1.7f;
+            base.parameters.depth = 0.8f;
+            base.parameters.mix = 0.7f;
+            base.parameters.interpolation = interpolation;
+
+            // Sample rate x tamano de bloque (1, impar, mayor que el tramo interno)
+            for (double sampleRate : { 44100.0, 48000.0, 96000.0, 192000.0 })
+                for (int blockSize : { 1, 64, 479, 4096 })
+                {
+                    if (quick && blockSize == 1 && sampleRate > 48000.0)
+                        continue;
+
+                    auto run = base;
+                    run.sampleRate = sampleRate;
+                    run.blockSize = blockSize;
+                    runs.push_back (run);
+                }
+
+            // Canales (Float4 / Float8 y varios grupos) x voces (plan Float4 / Float8)
+            for (int numChannels : { 1, 6, 9 })
+                for (int voices : { 1, 3, 8 })
+                {
+                    auto run = base;
+                    run.numChannels = numChannels;
+                    run.parameters.voices = voices;
+                    runs.push_back (run);
+                }
+
+            // Surround con desfase por canal: lectura por carril (gather)
+            for (int numChannels : { 3, 6, 12 })
+                for (int voices : { 1, 3 })
+                {
+                    auto run = base;
+                    run.numChannels = numChannels;
+                    run.parameters.voices = voices;
+                    run.channelOffsets = true;
+                    runs.push_back (run);
+                }
+
+            {
+                auto run = base;
+                run.numChannels = 12;
+                run.blockSize = 1;
+                run.channelOffsets = true;
+                runs.push_back (run);
+            }
+
+            // Barrido de parametros
+            for (float rate : { 0.1f, 2.0f })
+                for (float depth : { 0.0f, 0.3f, 1.0f })
+                    for (float mix : { 0.25f, 1.0f })
+                    {
+                        auto run = base;
+                        run.parameters.rate = rate;
+                        run.parameters.depth = depth;
+                        run.parameters.mix = mix;
+                        runs.push_back (run);
+                    }
+
+            for (const auto& run : runs)
+                report.add (kernel, describe (run), measureEngine<float> (run, seconds),
+                            tolerance * std::max (1.0, run.sampleRate / 48000.0));
+        }
+
+        // Reposo y reanudacion: silencio mas largo que el vaciado del delay line
+        for (int voices : { 1, 4 })
+        {
+            EngineRun run;
+            run.parameters.rate = 2.0f;
+            run.parameters.depth = 1.0f;
+            run.parameters.voices = voices;
+            run.withGap = true;
+            report.add ("engine_idle", describe (run), measureEngine<float> (run, std::max (seconds, 0.5)), idleTolerance);
+        }
+
+        // Memoria de trabajo propia (pool lleno): tramos de fallbackChunkFrames
+        for (int blockSize : { 480, 4096 })
+            for (bool channelOffsets : { false, true })
+            {
+                EngineRun run;
+                run.blockSize = blockSize;
+                run.numChannels = channelOffsets ? 12 : 2;
+                run.channelOffsets = channelOffsets;
+                run.parameters.voices = 3;
+                run.sharedWorkspace = false;
+                report.add ("engine_own_workspace", describe (run), measureEngine<float> (run, seconds), engineTolerance);
+            }
+
+        // Automatizacion: rampas de rate, depth y mix y fundido de estructura frente a
+        // las de libro de la referencia. Cambios en bordes de bloque, a mitad de bloque
+        // con las rampas ya acabadas y tan seguidos que llegan a mitad de rampa o de fundido
+        for (int interval : { 4 * 480, 1111, 317 })
+            for (bool changeStructure : { false, true })
+                for (bool channelOffsets : { false, true })
+                {
+                    EngineRun run;
+                    run.numChannels = channelOffsets ? 6 : 2;
+                    run.channelOffsets = channelOffsets;
+                    run.parameters.voices = 3;
+                    run.changes = makeAutomation (run.parameters, static_cast<int> (run.sampleRate * seconds), interval, changeStructure);
+                    report.add (changeStructure ? "engine_automation_structure" : "engine_automation",
+                                describe (run) + " every=" + std::to_string (interval), measureEngine<float> (run, seconds), automationTolerance);
+                }
+
+        // Tamano de bloque: el motor no depende del troceado (LFO en rejilla fija,
+        // rodilla a 2x exacta, reposo con la misma recursion), asi que frente a
+        // bloques de 480 la salida es identica. Senal sobre la rodilla y con silencio
+        {
+            EngineRun base;
+            base.numChannels = 6;
+            base.channelOffsets = true;
+            base.parameters.voices = 3;
+            base.parameters.depth = 1.0f;
+            base.parameters.mix = 0.7f;
+            base.level = 1.6f;
+            base.withGap = true;
+
+            const double invarianceSeconds = std::max (seconds, 0.5);
+            const auto expected = renderEngine (base, invarianceSeconds);
+
+            for (int blockSize : { 1, 37, 4096 })
+            {
+                auto run = base;
+                run.blockSize = blockSize;
+                report.add ("engine_block_size", describe (run) + " vs 480", getMaxDifference (renderEngine (run, invarianceSeconds), expected), 0.0);
+            }
+        }
+
+        // Memoria propia frente al pool con rate, depth y mix automatizados a mitad de
+        // bloque: cambia el tramo interno, no el resultado (LFO y rampas en rejilla fija)
+        for (bool channelOffsets : { false, true })
+        {
+            EngineRun run;
+            run.numChannels = channelOffsets ? 12 : 2;
+            run.channelOffsets = channelOffsets;
+            run.parameters.voices = 3;
+            run.level = 1.6f;
+            run.changes = makeAutomation (run.parameters, static_cast<int> (run.sampleRate * seconds), 1111);
+
+            auto own = run;
+            own.sharedWorkspace = false;
+            report.add ("engine_own_workspace", describe (own) + " vs pool",
+                        getMaxDifference (renderEngine (own, seconds), renderEngine (run, seconds)), 0.0);
+        }
+
+        // Camino double: mismo calculo en float, solo cambia la conversion
+        {
+            EngineRun run;
+            run.parameters.voices = 3;
+            report.add ("engine_double", describe (run),
+                        std::abs (measureEngine<double> (run, seconds) - measureEngine<float> (run, seconds)), 0.0);
+        }
+    }
+
+    // ChorusBatch: una instancia mono por carril, cada una con sus parametros
+    void verifyBatch (Report& report, bool quick)
+    {
+        const double sampleRate = 48000.0;
+        const int numInstances = 11;   // un grupo completo y otro a medias
+        const int blockSize = 333;
+        const int numSamples = static_cast<int> (sampleRate * (quick ? 0.25 : 1.0));
+
+        ChorusBatch batch;
+        batch.prepare (sampleRate, numInstances, blockSize);
+
+        std::vector<ChorusEngine::Parameters> parameters (static_cast<size_t> (numInstances));
+        std::vector<ChorusReference> references (static_cast<size_t> (numInstances));
+        std::vector<std::vector<float>> processed, expected;
+
+        for (int i = 0; i < numInstances; ++i)
+        {
+            auto& p = parameters[(size_t) i];
+            p.rate = 0.1f + 0.19f * i;
+            p.depth = static_cast<float> (i % 5) / 4.0f;
+            p.mix = 0.2f + 0.08f * i;
+            batch.setParameters (i, p);
+            references[(size_t) i].prepare (sampleRate, 1);
+
+            auto signal = makeSignal (1, numSamples, sampleRate, 0.5f, false)[0];
+            processed.push_back (signal);
+            expected.push_back (signal);
+        }
+
+        std::vector<float*> pointers (static_cast<size_t> (numInstances));
+        for (int offset = 0; offset < numSamples; offset += blockSize)
+        {
+            const int n = std::min (blockSize, numSamples - offset);
+            for (int i = 0; i < numInstances; ++i)
+            {
+                pointers[(size_t) i] = processed[(size_t) i].data() + offset;
+                float* referenceChannel = expected[(size_t) i].data() + offset;
+                references[(size_t) i].process (&referenceChannel, 1, n, parameters[(size_t) i]);
+            }
+
+            batch.process (pointers.data(), n);
+        }
+
+        double maxError = 0.0;
+        for (int i = 0; i < numInstances; ++i)
+            for (int s = 0; s < numSamples; ++s)
+                maxError = std::max (maxError, static_cast<double> (std::abs (processed[(size_t) i][(size_t) s] - expected[(size_t) i][(size_t) s])));
+
+        report.add ("batch", "sr=48000 block=333 instances=11", maxError, batchTolerance);
+    }
+}
+
+int runChorusVerification (bool quick, bool json)
+{
+    Report report (json);
+
+    verifyInterpolators (report, quick);
+    verifyLfo (report, quick);
+    verifyEngine (report, quick);
+    verifyBatch (report, quick);
+
+    std::printf ("verify: %d failure%s\n", report.getFailures(), report.getFailures() == 1 ? "" : "s");
+    return report.getFailures();
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+// Regresion de los caminos optimizados (ChorusEngine, ChorusBatch, ChorusLfo e
+// Interpolators) frente a ChorusReference, con una tolerancia por kernel.
+// Sin JUCE: KoruzBenchmark --verify lo llama, pero puede usarse desde cualquier
+// ejecutable que enlace KoruzDSP y ChorusReference.cpp.
+// Imprime una fila por comprobacion (CSV o JSON lines) y devuelve el numero de fallos.
+int runChorusVerification (bool quick, bool json);
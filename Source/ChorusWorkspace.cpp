@@ -0,0 +1,94 @@
+#include "ChorusWorkspace.h"
+#include "ChorusEngine.h"
+#include "SimdVec.h"
+#include <algorithm>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+    std::mutex poolMutex;
+    std::weak_ptr<ChorusWorkspacePool> sharedPool;
+}
+
+size_t ChorusWorkspace::getRequiredBytes (int chunkFrames)
+{
+    const auto chunk = static_cast<size_t> (chunkFrames);
+
+    // Mismo reparto que allocate; frames a lo ancho de Float8 (el mayor grupo)
+    return 5 * DspArena::bytesFor<float> (chunk)                                              // lfoSin, lfoCos, depth, wet, dry
+         + DspArena::bytesFor<int> (chunk * ChorusEngine::maxVoices)                            // tapIndices
+         + DspArena::bytesFor<float> (chunk * ChorusEngine::maxTaps * ChorusEngine::maxVoices)  // tapWeights
+         + DspArena::bytesFor<float> (chunk * Float8::width)                                    // frameBuffer
+         + DspArena::bytesFor<float> (OversampledClipper::getScratchFloats (chunkFrames));
+}
+
+void ChorusWorkspace::allocate (DspArena& arena, int newChunkFrames)
+{
+    chunkFrames = newChunkFrames;
+    const auto chunk = static_cast<size_t> (chunkFrames);
+
+    lfoSin = arena.allocate<float> (chunk);
+    lfoCos = arena.allocate<float> (chunk);
+    depthValues = arena.allocate<float> (chunk);
+    wetGains = arena.allocate<float> (chunk);
+    dryGains = arena.allocate<float> (chunk);
+    tapIndices = arena.allocate<int> (chunk * ChorusEngine::maxVoices);
+    tapWeights = arena.allocate<float> (chunk * ChorusEngine::maxTaps * ChorusEngine::maxVoices);
+    frameBuffer = arena.allocate<float> (chunk * Float8::width);
+    clipScratch = arena.allocate<float> (OversampledClipper::getScratchFloats (chunkFrames));
+}
+
+ChorusWorkspacePool::ChorusWorkspacePool (int newNumSlots)
+    : numSlots (std::min (std::max (newNumSlots, 1), maxSlots))
+{
+    arena.reserve (static_cast<size_t> (numSlots) * ChorusWorkspace::getRequiredBytes (chunkFrames));
+
+    for (int s = 0; s < numSlots; ++s)
+        slots[s].allocate (arena, chunkFrames);
+}
+
+std::shared_ptr<ChorusWorkspacePool> ChorusWorkspacePool::acquire()
+{
+    const std::lock_guard<std::mutex> lock (poolMutex);
+
+    auto pool = sharedPool.lock();
+    if (pool == nullptr)
+    {
+        // Hilos de audio del host y del pool de hilos; hardware_concurrency puede ser 0
+        pool = std::make_shared<ChorusWorkspacePool> (static_cast<int> (std::thread::hardware_concurrency()) + 2);
+        sharedPool = pool;
+    }
+
+    return pool;
+}
+
+size_t ChorusWorkspacePool::getSharedBytes()
+{
+    const std::lock_guard<std::mutex> lock (poolMutex);
+    const auto pool = sharedPool.lock();
+    return pool != nullptr ? pool->getBytes() : 0;
+}
+
+int ChorusWorkspacePool::getNumUsers()
+{
+    const std::lock_guard<std::mutex> lock (poolMutex);
+    return static_cast<int> (sharedPool.use_count());
+}
+
+int ChorusWorkspacePool::tryLock (int firstSlot) noexcept
+{
+    firstSlot = firstSlot >= 0 && firstSlot < numSlots ? firstSlot : 0;
+
+    // Un hueco ocupado se salta con una lectura, sin tomar su linea en exclusiva
+    for (int i = 0; i < numSlots; ++i)
+    {
+        const int slot = (firstSlot + i) % numSlots;
+        auto& busy = flags[slot].busy;
+
+        if (! busy.load (std::memory_order_relaxed) && ! busy.exchange (true, std::memory_order_acquire))
+            return slot;
+    }
+
+    return -1;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "DspArena.h"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// Memoria de trabajo de un ChorusEngine: LFO del tramo, plan de lectura, ganancias
+// por frame, frames intercalados y tramo del clipper. Se reescribe entera en cada
+// tramo y no guarda nada entre llamadas, asi que no tiene por que ser de cada
+// instancia: mientras process no la suelta nadie mas la toca.
+struct ChorusWorkspace
+{
+    float* lfoSin = nullptr;
+    float* lfoCos = nullptr;
+    int* tapIndices = nullptr;
+    float* tapWeights = nullptr;
+    float* depthValues = nullptr;
+    float* wetGains = nullptr;
+    float* dryGains = nullptr;
+    float* frameBuffer = nullptr;
+    float* clipScratch = nullptr;
+    int chunkFrames = 0;
+
+    // Bytes para tramos de hasta chunkFrames frames, con cualquier numero de canales
+    static size_t getRequiredBytes (int chunkFrames);
+
+    // Reparte del arena (que debe tener getRequiredBytes (chunkFrames) libres)
+    void allocate (DspArena& arena, int chunkFrames);
+};
+
+// Memoria de trabajo compartida por todos los motores del proceso.
+// - Se crea con el primer prepare y se libera al destruirse el ultimo motor que la
+//   usa (contada por referencias; acquire no es para el hilo de audio).
+// - Tiene un hueco por hilo que pueda estar procesando a la vez (nucleos + 2). Cada
+//   process toma un hueco libre sin locks ni memoria dinamica y lo suelta al
+//   terminar; si estan todos ocupados, el motor usa la suya propia, mas pequena.
+// - Lo que comparten los hilos sin escribir (los punteros de cada hueco) no cambia
+//   despues de construir. Lo que se escribe va por hueco: cada flag de ocupado en
+//   su propia linea de cache y cada hueco en tramos alineados del arena, asi que
+//   dos hilos con huecos distintos no se pisan ninguna linea.
+class ChorusWorkspacePool
+{
+public:
+    static constexpr int maxSlots = 64;
+    static constexpr int chunkFrames = 512;
+
+    explicit ChorusWorkspacePool (int numSlots);
+
+    // Pool del proceso; lo crea si ningun motor lo tiene
+    static std::shared_ptr<ChorusWorkspacePool> acquire();
+
+    // Bytes del pool vivo (0 si no hay ninguno) y motores que lo comparten
+    static size_t getSharedBytes();
+    static int getNumUsers();
+
+    // Hueco libre o -1, buscando desde firstSlot: cada motor pasa el ultimo que
+    // uso para volver al mismo (cache caliente). Sin estado por hilo: un
+    // thread_local en un plugin cargado con dlopen puede reservar memoria
+    int tryLock (int firstSlot = 0) noexcept;
+    void unlock (int slot) noexcept { flags[slot].busy.store (false, std::memory_order_release); }
+
+    const ChorusWorkspace& getWorkspace (int slot) const { return slots[slot]; }
+    int getNumSlots() const { return numSlots; }
+    size_t getBytes() const { return arena.getCapacity(); }
+
+private:
+    struct alignas (64) SlotFlag
+    {
+        std::atomic<bool> busy { false };
+    };
+
+    DspArena arena;
+    ChorusWorkspace slots[maxSlots];
+    int numSlots = 0;
+    SlotFlag flags[maxSlots];
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+// Gobernador de CPU, independiente de JUCE.
+// Compara el tiempo de cada bloque con su presupuesto en tiempo real
+// (numSamples / sampleRate) y, cuando la media movil pasa del umbral, baja un
+// nivel de calidad; cuando vuelve a haber margen durante un rato, sube uno.
+// Que significa cada nivel lo decide quien lo usa (ver PluginProcessor).
+class CpuGovernor
+{
+public:
+    static constexpr int maxTier = 3;
+    static constexpr double averagingSeconds = 0.5;   // constante de tiempo de la media
+    static constexpr double holdSeconds = 1.0;        // espera tras un cambio de nivel
+    static constexpr double recoverSeconds = 3.0;     // margen sostenido para subir
+    static constexpr double maxRecoverSeconds = 48.0;
+    static constexpr float recoverRatio = 0.5f;       // histeresis: subir por debajo de umbral * ratio
+
+    void prepare (double newSampleRate)
+    {
+        sampleRate = newSampleRate;
+        reset();
+    }
+
+    void reset()
+    {
+        load = 0.0;
+        tier = 0;
+        holdRemaining = 0.0;
+        headroomTime = 0.0;
+        recoverTime = recoverSeconds;
+        sinceRecovery = maxRecoverSeconds;
+    }
+
+    // Fraccion del presupuesto a partir de la cual se degrada (0.25 = un cuarto del bloque)
+    void setThreshold (float fractionOfBudget) { threshold = std::max (fractionOfBudget, 1.0e-6f); }
+    float getThreshold() const { return threshold; }
+
+    // Registra un bloque y devuelve el nivel para el siguiente (0 = calidad completa)
+    int update (double elapsedSeconds, int numSamples)
+    {
+        if (numSamples <= 0 || sampleRate <= 0.0)
+            return tier;
+
+        const double blockSeconds = numSamples / sampleRate;
+        const double alpha = 1.0 - std::exp (-blockSeconds / averagingSeconds);
+        load += alpha * (elapsedSeconds / blockSeconds - load);
+
+        sinceRecovery += blockSeconds;
+        holdRemaining -= blockSeconds;
+        if (holdRemaining > 0.0)
+            return tier;
+
+        if (load > threshold && tier < maxTier)
+        {
+            // Si la ultima subida no se ha sostenido, la siguiente espera el doble
+            recoverTime = sinceRecovery < recoverTime ? std::min (recoverTime * 2.0, maxRecoverSeconds)
+                                                      : recoverSeconds;
+            changeTier (tier + 1);
+        }
+        else if (load < threshold * recoverRatio && tier > 0)
+        {
+            headroomTime += blockSeconds;
+            if (headroomTime >= recoverTime)
+            {
+                changeTier (tier - 1);
+                sinceRecovery = 0.0;
+            }
+        }
+        else
+        {
+            headroomTime = 0.0;
+        }
+
+        return tier;
+    }
+
+    int getTier() const { return tier; }
+
+    // Media movil del tiempo de proceso / tiempo real del bloque
+    float getLoad() const { return static_cast<float> (load); }
+
+private:
+    void changeTier (int newTier)
+    {
+        tier = newTier;
+        holdRemaining = holdSeconds;
+        headroomTime = 0.0;
+    }
+
+    double sampleRate = 44100.0;
+    float threshold = 0.25f;
+    double load = 0.0;
+    int tier = 0;
+    double holdRemaining = 0.0;
+    double headroomTime = 0.0;
+    double recoverTime = recoverSeconds;
+    double sinceRecovery = maxRecoverSeconds;
+};
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+
+// Delay line multicanal para ChorusEngine.
+// - Capacidad potencia de dos: el indice se envuelve con una mascara.
+// - Frames intercalados [frame][carril]: un frame de todos los canales es un vector SIMD.
+//   Con planarLanes cada carril del grupo es un tramo contiguo [carril][frame]:
+//   es el layout para lecturas por carril (cada canal en su propia posicion),
+//   donde una carga contigua trae los taps de un carril.
+// - Los primeros guardFrames frames se duplican al final, asi la ventana de
+//   interpolacion (hasta idx0..idx0+5, Lagrange de 6 puntos) siempre es memoria
+//   contigua, sin envolver.
+// - Todos los grupos de carriles viven en un unico bloque contiguo que no es
+//   suyo: lo reparte el DspArena del motor (alineado a 64 bytes).
+class DelayLine
+{
+public:
+    static constexpr int guardFrames = 8;
+
+    static int getCapacityFor (int minimumFrames)
+    {
+        int frames = 1;
+        while (frames < minimumFrames)
+            frames <<= 1;
+
+        return frames;
+    }
+
+    // Floats que necesita prepare para esta configuracion
+    static size_t getRequiredFloats (int minimumFrames, int laneWidth, int numGroups)
+    {
+        return static_cast<size_t> (getCapacityFor (minimumFrames) + guardFrames)
+             * static_cast<size_t> (laneWidth) * static_cast<size_t> (numGroups);
+    }
+
+    // memory debe tener getRequiredFloats (...) floats y vivir mas que el delay line
+    void prepare (int minimumFrames, int newLaneWidth, int newNumGroups, float* memory, bool planarLanes = false)
+    {
+        capacity = getCapacityFor (minimumFrames);
+        mask = capacity - 1;
+        laneWidth = newLaneWidth;
+        numGroups = newNumGroups;
+        groupStride = static_cast<size_t> (capacity + guardFrames) * static_cast<size_t> (laneWidth);
+        planar = planarLanes;
+
+        storage = memory;
+        storageSize = groupStride * static_cast<size_t> (numGroups);
+        clear();
+    }
+
+    void release()
+    {
+        storage = nullptr;
+        storageSize = 0;
+        capacity = 0;
+        mask = 0;
+        numGroups = 0;
+    }
+
+    // Cambia de layout sobre la misma memoria; el contenido se pierde
+    void setPlanar (bool planarLanes)
+    {
+        planar = planarLanes;
+        clear();
+    }
+
+    void clear()
+    {
+        if (storage != nullptr)
+            std::memset (storage, 0, storageSize * sizeof (float));
+    }
+
+    float* getGroup (int group) const    { return storage + groupStride * static_cast<size_t> (group); }
+    int getCapacity() const              { return capacity; }
+    int getMask() const                  { return mask; }
+    bool isPlanar() const                { return planar; }
+
+    // Escribe un frame y su copia de guarda; sin ramas: si position >= guardFrames
+    // la segunda escritura cae sobre el mismo frame
+    template <typename Vec>
+    void write (float* group, int position, Vec frame) const
+    {
+        const int mirror = position + (capacity & -static_cast<int> (position < guardFrames));
+        frame.store (group + position * laneWidth);
+        frame.store (group + mirror * laneWidth);
+    }
+
+    // Primer frame de la ventana de lectura; idx0..idx0+guardFrames-1 son contiguos
+    const float* getWindow (const float* group, int idx0) const
+    {
+        return group + (idx0 & mask) * laneWidth;
+    }
+
+    // LAYOUT PLANAR - tramo de un carril; idx0..idx0+guardFrames-1 son contiguos
+    float* getLane (float* group, int lane) const
+    {
+        return group + static_cast<size_t> (lane) * static_cast<size_t> (capacity + guardFrames);
+    }
+
+    void writeLane (float* lane, int position, float value) const
+    {
+        const int mirror = position + (capacity & -static_cast<int> (position < guardFrames));
+        lane[position] = value;
+        lane[mirror] = value;
+    }
+
+private:
+    float* storage = nullptr;
+    size_t storageSize = 0;
+    size_t groupStride = 0;
+    int capacity = 0;
+    int mask = 0;
+    int laneWidth = 4;
+    int numGroups = 0;
+    bool planar = false;
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+
+// Arena de memoria para el estado DSP: una unica reserva alineada a linea de
+// cache que se reparte por tramos (bump allocator). Se dimensiona una vez para
+// la mayor configuracion; un prepare posterior solo rebobina y vuelve a
+// repartir, sin pedir ni devolver memoria.
+class DspArena
+{
+public:
+    static constexpr size_t alignment = 64;
+
+    // Bytes que ocupa un tramo de count elementos, redondeado a la alineacion
+    template <typename T>
+    static constexpr size_t bytesFor (size_t count)
+    {
+        return (count * sizeof (T) + alignment - 1) & ~(alignment - 1);
+    }
+
+    // Reserva al menos numBytes; si ya hay bastante no hace nada.
+    // Invalida todo lo repartido: nunca llamar con el audio en marcha
+    void reserve (size_t numBytes)
+    {
+        if (numBytes <= capacity)
+            return;
+
+        storage.reset (static_cast<unsigned char*> (::operator new (numBytes, std::align_val_t (alignment))));
+        capacity = numBytes;
+        used = 0;
+    }
+
+    void release()
+    {
+        storage.reset();
+        capacity = 0;
+        used = 0;
+    }
+
+    // Vuelve a repartir desde el principio; la memoria se conserva
+    void rewind() { used = 0; }
+
+    // Tramo alineado de count elementos, a cero
+    template <typename T>
+    T* allocate (size_t count)
+    {
+        const size_t numBytes = bytesFor<T> (count);
+        assert (used + numBytes <= capacity);
+
+        auto* block = storage.get() + used;
+        used += numBytes;
+        std::memset (block, 0, numBytes);
+        return reinterpret_cast<T*> (block);
+    }
+
+    size_t getCapacity() const { return capacity; }
+    size_t getUsed() const     { return used; }
+
+private:
+    struct AlignedDeleter
+    {
+        void operator() (unsigned char* p) const { ::operator delete (p, std::align_val_t (alignment)); }
+    };
+
+    std::unique_ptr<unsigned char, AlignedDeleter> storage;
+    size_t capacity = 0;
+    size_t used = 0;
+};
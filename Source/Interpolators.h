@@ -0,0 +1,173 @@
+#pragma once
+
+#include "SimdVec.h"
+
+// Politicas de interpolacion del tap de lectura de ChorusEngine.
+//
+// La posicion de lectura es idx1 + t, con t = ceil(delay) - delay en (0, 1]
+// (idx1 es el frame mas antiguo de los dos que rodean la lectura). Cada politica
+// define cuantos frames lee (numTaps), donde empieza la ventana respecto a idx1
+// (firstTap) y como calcula sus coeficientes una vez por frame y voz en el plan.
+// computeWeights escribe numTaps vectores separados por stride floats.
+//
+// read() combina la ventana de un grupo de carriles con los coeficientes de una
+// voz. readLanes() es lo mismo cuando cada carril lee en su propia posicion
+// (canales con desfase de LFO): taps ya traspuestos (taps[k] = tap k de cada
+// carril) y coeficientes por carril.
+// Solo el allpass tiene estado (la salida anterior de esa voz).
+
+// Eco: lineal, 2 puntos
+struct LinearInterpolator
+{
+    static constexpr int numTaps = 2;
+    static constexpr int firstTap = 0;
+    static constexpr bool hasState = false;
+
+    template <typename Vec>
+    static KORUZ_INLINE void computeWeights (Vec t, float* weights, int stride)
+    {
+        (Vec::broadcast (1.0f) - t).store (weights);
+        t.store (weights + stride);
+    }
+
+    template <typename Vec>
+    static KORUZ_INLINE Vec read (const float* window, const float* weights, int stride, Vec&)
+    {
+        constexpr int W = Vec::width;
+        return Vec::load (window)     * Vec::broadcast (weights[0])
+             + Vec::load (window + W) * Vec::broadcast (weights[stride]);
+    }
+
+    template <typename Vec>
+    static KORUZ_INLINE Vec readLanes (const Vec* taps, const float* weights, int stride, Vec&)
+    {
+        return taps[0] * Vec::load (weights)
+             + taps[1] * Vec::load (weights + stride);
+    }
+};
+
+// Normal: Catmull-Rom, 4 puntos (el interpolador original de Koruz)
+struct CatmullRomInterpolator
+{
+    static constexpr int numTaps = 4;
+    static constexpr int firstTap = -1;
+    static constexpr bool hasState = false;
+
+    template <typename Vec>
+    static KORUZ_INLINE void computeWeights (Vec t, float* weights, int stride)
+    {
+        const auto half = Vec::broadcast (0.5f);
+        const auto t2 = t * t;
+        const auto t3 = t2 * t;
+
+        (t2 - half * t - half * t3).store (weights);
+        (Vec::broadcast (1.0f) - Vec::broadcast (2.5f) * t2 + Vec::broadcast (1.5f) * t3).store (weights + stride);
+        (half * t + Vec::broadcast (2.0f) * t2 - Vec::broadcast (1.5f) * t3).store (weights + 2 * stride);
+        (half * t3 - half * t2).store (weights + 3 * stride);
+    }
+
+    template <typename Vec>
+    static KORUZ_INLINE Vec read (const float* window, const float* weights, int stride, Vec&)
+    {
+        constexpr int W = Vec::width;
+        return Vec::load (window)         * Vec::broadcast (weights[0])
+             + Vec::load (window + W)     * Vec::broadcast (weights[stride])
+             + Vec::load (window + 2 * W) * Vec::broadcast (weights[2 * stride])
+             + Vec::load (window + 3 * W) * Vec::broadcast (weights[3 * stride]);
+    }
+
+    template <typename Vec>
+    static KORUZ_INLINE Vec readLanes (const Vec* taps, const float* weights, int stride, Vec&)
+    {
+        return taps[0] * Vec::load (weights)
+             + taps[1] * Vec::load (weights + stride)
+             + taps[2] * Vec::load (weights + 2 * stride)
+             + taps[3] * Vec::load (weights + 3 * stride);
+    }
+};
+
+// HQ: Lagrange de 6 puntos (taps en -2..3 respecto a idx1)
+struct LagrangeInterpolator
+{
+    static constexpr int numTaps = 6;
+    static constexpr int firstTap = -2;
+    static constexpr bool hasState = false;
+
+    template <typename Vec>
+    static KORUZ_INLINE void computeWeights (Vec t, float* weights, int stride)
+    {
+        const auto one = Vec::broadcast (1.0f);
+        const auto two = Vec::broadcast (2.0f);
+        const auto three = Vec::broadcast (3.0f);
+
+        // w_k = prod_{j != k} (t - j) / (k - j), agrupando productos comunes
+        const auto a = (t + two) * (t + one);
+        const auto b = t * (t - one);
+        const auto c = (t - two) * (t - three);
+
+        ((t + one) * b * c * Vec::broadcast (-1.0f / 120.0f)).store (weights);
+        ((t + two) * b * c * Vec::broadcast (1.0f / 24.0f)).store (weights + stride);
+        (a * (t - one) * c * Vec::broadcast (-1.0f / 12.0f)).store (weights + 2 * stride);
+        (a * t * c * Vec::broadcast (1.0f / 12.0f)).store (weights + 3 * stride);
+        (a * b * (t - three) * Vec::broadcast (-1.0f / 24.0f)).store (weights + 4 * stride);
+        (a * b * (t - two) * Vec::broadcast (1.0f / 120.0f)).store (weights + 5 * stride);
+    }
+
+    template <typename Vec>
+    static KORUZ_INLINE Vec read (const float* window, const float* weights, int stride, Vec&)
+    {
+        constexpr int W = Vec::width;
+        return Vec::load (window)         * Vec::broadcast (weights[0])
+             + Vec::load (window + W)     * Vec::broadcast (weights[stride])
+             + Vec::load (window + 2 * W) * Vec::broadcast (weights[2 * stride])
+             + Vec::load (window + 3 * W) * Vec::broadcast (weights[3 * stride])
+             + Vec::load (window + 4 * W) * Vec::broadcast (weights[4 * stride])
+             + Vec::load (window + 5 * W) * Vec::broadcast (weights[5 * stride]);
+    }
+
+    template <typename Vec>
+    static KORUZ_INLINE Vec readLanes (const Vec* taps, const float* weights, int stride, Vec&)
+    {
+        return taps[0] * Vec::load (weights)
+             + taps[1] * Vec::load (weights + stride)
+             + taps[2] * Vec::load (weights + 2 * stride)
+             + taps[3] * Vec::load (weights + 3 * stride)
+             + taps[4] * Vec::load (weights + 4 * stride)
+             + taps[5] * Vec::load (weights + 5 * stride);
+    }
+};
+
+// Allpass de primer orden: respuesta plana en magnitud con el coste del lineal,
+// pero con estado (y[n-1]) y un pequeno transitorio cuando cambia el entero del delay.
+// Retardo fraccional respecto al frame mas nuevo: eta = 1 - t, a = (1 - eta) / (1 + eta)
+struct AllpassInterpolator
+{
+    static constexpr int numTaps = 2;
+    static constexpr int firstTap = 0;
+    static constexpr bool hasState = true;
+
+    template <typename Vec>
+    static KORUZ_INLINE void computeWeights (Vec t, float* weights, int)
+    {
+        // (1 - eta) / (1 + eta) con eta = 1 - t
+        (t / (Vec::broadcast (2.0f) - t)).store (weights);
+    }
+
+    template <typename Vec>
+    static KORUZ_INLINE Vec read (const float* window, const float* weights, int, Vec& previous)
+    {
+        constexpr int W = Vec::width;
+        const auto a = Vec::broadcast (weights[0]);
+        const auto output = Vec::load (window) + a * (Vec::load (window + W) - previous);
+        previous = output;
+        return output;
+    }
+
+    template <typename Vec>
+    static KORUZ_INLINE Vec readLanes (const Vec* taps, const float* weights, int, Vec& previous)
+    {
+        const auto output = taps[0] + Vec::load (weights) * (taps[1] - previous);
+        previous = output;
+        return output;
+    }
+};
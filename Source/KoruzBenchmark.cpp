@@ -0,0 +1,984 @@
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "ChorusBatch.h"
+#include "ChorusState.h"
+#include "ChorusVerify.h"
+#include "KoruzTrace.h"
+#include "Interpolators.h"
+#include "SimdVec.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Benchmark headless de KoruzAudioProcessor::processBlock.
+// Salida: CSV (por defecto) o JSON lines, una fila por configuracion.
+
+namespace
+{
+    struct BenchConfig
+    {
+        int blockSize = 512;
+        double sampleRate = 44100.0;
+        int numChannels = 2;
+        float depth = 0.4f;
+        float mix = 0.5f;
+    };
+
+    struct BenchResult
+    {
+        double nsPerFrame = 0.0;
+        double nsPerSample = 0.0;
+        double realtimeFactor = 0.0;
+        double instancesPerCore = 0.0;
+    };
+
+    struct BenchOptions
+    {
+        double secondsPerRun = 2.0;
+        int repeats = 3;
+        bool json = false;
+        bool quick = false;
+        bool batch = false;
+        bool state = false;
+        bool doublePrecision = false;
+        bool quality = false;
+        bool governor = false;
+        bool verify = false;
+        bool surround = false;
+        bool memory = false;
+        std::string tracePath;
+    };
+
+    void setParameter (juce::AudioParameterFloat* param, float value)
+    {
+        param->setValueNotifyingHost (param->convertTo0to1 (value));
+    }
+
+    // Valor normalizado directo, sin listeners (lo que hace un host al automatizar)
+    void setAutomatedValue (juce::AudioProcessorParameter* param, float normalisedValue)
+    {
+        param->setValue (normalisedValue);
+    }
+
+    BenchResult runConfig (const BenchConfig& config, const BenchOptions& options)
+    {
+        KoruzAudioProcessor processor;
+
+        const auto layout = config.numChannels == 1 ? juce::AudioChannelSet::mono()
+                                                    : juce::AudioChannelSet::stereo();
+        juce::AudioProcessor::BusesLayout buses;
+        buses.inputBuses.add (layout);
+        buses.outputBuses.add (layout);
+        processor.setBusesLayout (buses);
+        processor.setRateAndBufferSizeDetails (config.sampleRate, config.blockSize);
+        processor.prepareToPlay (config.sampleRate, config.blockSize);
+
+        setParameter (processor.getRateParam(), 0.8f);
+        setParameter (processor.getDepthParam(), config.depth);
+        setParameter (processor.getMixParam(), config.mix);
+
+        // Ruido a -12 dBFS, igual en todas las configuraciones
+        juce::AudioBuffer<float> source (config.numChannels, config.blockSize);
+        std::mt19937 rng (1234);
+        std::uniform_real_distribution<float> dist (-0.25f, 0.25f);
+        for (int ch = 0; ch < config.numChannels; ++ch)
+            for (int i = 0; i < config.blockSize; ++i)
+                source.setSample (ch, i, dist (rng));
+
+        juce::AudioBuffer<float> buffer (config.numChannels, config.blockSize);
+        juce::MidiBuffer midi;
+
+        const auto numBlocks = std::max (1, static_cast<int> (options.secondsPerRun * config.sampleRate / config.blockSize));
+
+        // Calentamiento
+        for (int b = 0; b < std::min (numBlocks, 64); ++b)
+        {
+            buffer.makeCopyOf (source, true);
+            processor.processBlock (buffer, midi);
+        }
+
+        double bestNs = 0.0;
+        for (int r = 0; r < options.repeats; ++r)
+        {
+            double elapsedNs = 0.0;
+            for (int b = 0; b < numBlocks; ++b)
+            {
+                buffer.makeCopyOf (source, true);
+
+                const auto start = std::chrono::steady_clock::now();
+                processor.processBlock (buffer, midi);
+                const auto end = std::chrono::steady_clock::now();
+
+                elapsedNs += static_cast<double> (std::chrono::duration_cast<std::chrono::nanoseconds> (end - start).count());
+            }
+
+            if (r == 0 || elapsedNs < bestNs)
+                bestNs = elapsedNs;
+        }
+
+        processor.releaseResources();
+
+        const auto frames = static_cast<double> (numBlocks) * config.blockSize;
+
+        BenchResult result;
+        result.nsPerFrame = bestNs / frames;
+        result.nsPerSample = result.nsPerFrame / config.numChannels;
+        result.realtimeFactor = (bestNs * 1.0e-9) / (frames / config.sampleRate);
+        result.instancesPerCore = result.realtimeFactor > 0.0 ? 1.0 / result.realtimeFactor : 0.0;
+        return result;
+    }
+
+    void printHeader (const BenchOptions& options)
+    {
+        if (! options.json)
+            std::printf ("block_size,sample_rate,channels,depth,mix,ns_per_frame,ns_per_sample,realtime_factor,instances_per_core\n");
+    }
+
+    void printResult (const BenchConfig& config, const BenchResult& result, const BenchOptions& options)
+    {
+        if (options.json)
+        {
+            std::printf ("{\"block_size\":%d,\"sample_rate\":%.0f,\"channels\":%d,\"depth\":%.2f,\"mix\":%.2f,"
+                         "\"ns_per_frame\":%.3f,\"ns_per_sample\":%.3f,\"realtime_factor\":%.6f,\"instances_per_core\":%.1f}\n",
+                         config.blockSize, config.sampleRate, config.numChannels, config.depth, config.mix,
+                         result.nsPerFrame, result.nsPerSample, result.realtimeFactor, result.instancesPerCore);
+        }
+        else
+        {
+            std::printf ("%d,%.0f,%d,%.2f,%.2f,%.3f,%.3f,%.6f,%.1f\n",
+                         config.blockSize, config.sampleRate, config.numChannels, config.depth, config.mix,
+                         result.nsPerFrame, result.nsPerSample, result.realtimeFactor, result.instancesPerCore);
+        }
+
+        std::fflush (stdout);
+    }
+
+    template <typename ProcessFn>
+    double timeBlocks (int numBlocks, int repeats, ProcessFn&& processOneBlock)
+    {
+        double bestNs = 0.0;
+        for (int r = 0; r < repeats; ++r)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            for (int b = 0; b < numBlocks; ++b)
+                processOneBlock();
+            const auto end = std::chrono::steady_clock::now();
+
+            const auto elapsedNs = static_cast<double> (std::chrono::duration_cast<std::chrono::nanoseconds> (end - start).count());
+            if (r == 0 || elapsedNs < bestNs)
+                bestNs = elapsedNs;
+        }
+        return bestNs;
+    }
+
+    // N pistas mono: N ChorusEngine independientes contra un ChorusBatch
+    void runBatchSweep (const BenchOptions& options)
+    {
+        const double sampleRate = 48000.0;
+        const int blockSize = 512;
+        const int numBlocks = std::max (1, static_cast<int> (options.secondsPerRun * sampleRate / blockSize));
+
+        if (! options.json)
+            std::printf ("mode,instances,block_size,sample_rate,ns_per_instance_sample,instances_per_core\n");
+
+        for (int numInstances : { 1, 8, 32, 128, 512 })
+        {
+            std::vector<std::vector<float>> buffers (static_cast<size_t> (numInstances), std::vector<float> (blockSize));
+            std::vector<float*> pointers;
+            std::mt19937 rng (99);
+            std::uniform_real_distribution<float> dist (-0.25f, 0.25f);
+            for (auto& b : buffers)
+            {
+                for (auto& x : b)
+                    x = dist (rng);
+                pointers.push_back (b.data());
+            }
+
+            std::vector<ChorusEngine> engines (static_cast<size_t> (numInstances));
+            ChorusBatch batch;
+            batch.prepare (sampleRate, numInstances, blockSize);
+
+            for (int i = 0; i < numInstances; ++i)
+            {
+                ChorusEngine::Parameters params;
+                params.rate = 0.1f + 1.9f * static_cast<float> (i % 17) / 16.0f;
+                params.depth = static_cast<float> (i % 11) / 10.0f;
+                params.mix = 0.5f;
+
+                engines[(size_t) i].prepare (sampleRate, 1, blockSize);
+                engines[(size_t) i].setParameters (params);
+                batch.setParameters (i, params);
+            }
+
+            const auto separateNs = timeBlocks (numBlocks, options.repeats, [&]
+            {
+                ScopedFlushDenormals noDenormals;
+                for (int i = 0; i < numInstances; ++i)
+                    engines[(size_t) i].process (&pointers[(size_t) i], 1, blockSize);
+            });
+
+            const auto batchNs = timeBlocks (numBlocks, options.repeats, [&]
+            {
+                batch.process (pointers.data(), blockSize);
+            });
+
+            const auto instanceSamples = static_cast<double> (numBlocks) * blockSize * numInstances;
+            const std::pair<const char*, double> rows[] = { { "separate", separateNs }, { "batch", batchNs } };
+
+            for (const auto& row : rows)
+            {
+                const auto nsPerSample = row.second / instanceSamples;
+                const auto instancesPerCore = 1.0e9 / (nsPerSample * sampleRate);
+
+                if (options.json)
+                    std::printf ("{\"mode\":\"%s\",\"instances\":%d,\"block_size\":%d,\"sample_rate\":%.0f,"
+                                 "\"ns_per_instance_sample\":%.3f,\"instances_per_core\":%.1f}\n",
+                                 row.first, numInstances, blockSize, sampleRate, nsPerSample, instancesPerCore);
+                else
+                    std::printf ("%s,%d,%d,%.0f,%.3f,%.1f\n", row.first, numInstances, blockSize, sampleRate, nsPerSample, instancesPerCore);
+            }
+
+            std::fflush (stdout);
+        }
+    }
+
+    // Host de 64 bits: convertir a float y volver alrededor del plugin contra processBlock<double>
+    void runDoubleSweep (const BenchOptions& options)
+    {
+        const double sampleRate = 48000.0;
+
+        if (! options.json)
+            std::printf ("mode,block_size,sample_rate,channels,ns_per_frame\n");
+
+        for (int blockSize : { 64, 512, 4096 })
+            for (int numChannels : { 1, 2 })
+            {
+                KoruzAudioProcessor processor;
+
+                const auto layout = numChannels == 1 ? juce::AudioChannelSet::mono() : juce::AudioChannelSet::stereo();
+                juce::AudioProcessor::BusesLayout buses;
+                buses.inputBuses.add (layout);
+                buses.outputBuses.add (layout);
+                processor.setBusesLayout (buses);
+                processor.setRateAndBufferSizeDetails (sampleRate, blockSize);
+                processor.prepareToPlay (sampleRate, blockSize);
+
+                juce::AudioBuffer<double> source (numChannels, blockSize);
+                std::mt19937 rng (1234);
+                std::uniform_real_distribution<double> dist (-0.25, 0.25);
+                for (int ch = 0; ch < numChannels; ++ch)
+                    for (int i = 0; i < blockSize; ++i)
+                        source.setSample (ch, i, dist (rng));
+
+                juce::AudioBuffer<double> hostBuffer (numChannels, blockSize);
+                juce::AudioBuffer<float> floatBuffer (numChannels, blockSize);
+                juce::MidiBuffer midi;
+
+                const int numBlocks = std::max (1, static_cast<int> (options.secondsPerRun * sampleRate / blockSize));
+
+                const auto convertedNs = timeBlocks (numBlocks, options.repeats, [&]
+                {
+                    hostBuffer.makeCopyOf (source, true);
+                    floatBuffer.makeCopyOf (hostBuffer, true);
+                    processor.processBlock (floatBuffer, midi);
+                    hostBuffer.makeCopyOf (floatBuffer, true);
+                });
+
+                const auto nativeNs = timeBlocks (numBlocks, options.repeats, [&]
+                {
+                    hostBuffer.makeCopyOf (source, true);
+                    processor.processBlock (hostBuffer, midi);
+                });
+
+                processor.releaseResources();
+
+                const std::pair<const char*, double> rows[] = { { "double_converted", convertedNs }, { "double_native", nativeNs } };
+                for (const auto& row : rows)
+                {
+                    const auto nsPerFrame = row.second / (static_cast<double> (numBlocks) * blockSize);
+
+                    if (options.json)
+                        std::printf ("{\"mode\":\"%s\",\"block_size\":%d,\"sample_rate\":%.0f,\"channels\":%d,\"ns_per_frame\":%.3f}\n",
+                                     row.first, blockSize, sampleRate, numChannels, nsPerFrame);
+                    else
+                        std::printf ("%s,%d,%.0f,%d,%.3f\n", row.first, blockSize, sampleRate, numChannels, nsPerFrame);
+                }
+
+                std::fflush (stdout);
+            }
+    }
+
+    // Un bed surround en un solo plugin (desfase de LFO por canal) contra una
+    // instancia stereo por pareja de canales, como se hacia antes de aceptar surround
+    void runSurroundSweep (const BenchOptions& options)
+    {
+        const double sampleRate = 48000.0;
+        const int blockSize = 512;
+        const int numBlocks = std::max (1, static_cast<int> (options.secondsPerRun * sampleRate / blockSize));
+
+        const std::pair<const char*, juce::AudioChannelSet> layouts[] = {
+            { "5.1", juce::AudioChannelSet::create5point1() },
+            { "7.1", juce::AudioChannelSet::create7point1() },
+            { "7.1.4", juce::AudioChannelSet::create7point1point4() }
+        };
+
+        if (! options.json)
+            std::printf ("mode,layout,channels,voices,block_size,sample_rate,ns_per_channel_sample\n");
+
+        auto makeProcessor = [&] (const juce::AudioChannelSet& layout, int voices)
+        {
+            auto processor = std::make_unique<KoruzAudioProcessor>();
+            juce::AudioProcessor::BusesLayout buses;
+            buses.inputBuses.add (layout);
+            buses.outputBuses.add (layout);
+            processor->setBusesLayout (buses);
+            setParameter (processor->getDepthParam(), 0.6f);
+            processor->getVoicesParam()->setValueNotifyingHost (processor->getVoicesParam()->convertTo0to1 (static_cast<float> (voices)));
+            processor->setRateAndBufferSizeDetails (sampleRate, blockSize);
+            processor->prepareToPlay (sampleRate, blockSize);
+            return processor;
+        };
+
+        for (const auto& layout : layouts)
+            for (int voices : { 1, 3 })
+            {
+                const int numChannels = layout.second.size();
+                const int numPairs = numChannels / 2;
+
+                juce::AudioBuffer<float> source (numChannels, blockSize);
+                std::mt19937 rng (7);
+                std::uniform_real_distribution<float> dist (-0.25f, 0.25f);
+                for (int ch = 0; ch < numChannels; ++ch)
+                    for (int i = 0; i < blockSize; ++i)
+                        source.setSample (ch, i, dist (rng));
+
+                juce::AudioBuffer<float> buffer (numChannels, blockSize);
+                juce::MidiBuffer midi;
+
+                std::vector<std::unique_ptr<KoruzAudioProcessor>> pairs;
+                for (int p = 0; p < numPairs; ++p)
+                    pairs.push_back (makeProcessor (juce::AudioChannelSet::stereo(), voices));
+
+                const auto pairsNs = timeBlocks (numBlocks, options.repeats, [&]
+                {
+                    buffer.makeCopyOf (source, true);
+                    for (int p = 0; p < numPairs; ++p)
+                    {
+                        juce::AudioBuffer<float> pair (buffer.getArrayOfWritePointers() + 2 * p, 2, blockSize);
+                        pairs[(size_t) p]->processBlock (pair, midi);
+                    }
+                });
+
+                auto bed = makeProcessor (layout.second, voices);
+                const auto bedNs = timeBlocks (numBlocks, options.repeats, [&]
+                {
+                    buffer.makeCopyOf (source, true);
+                    bed->processBlock (buffer, midi);
+                });
+
+                const std::pair<const char*, double> rows[] = { { "stereo_instances", pairsNs }, { "bed", bedNs } };
+                for (const auto& row : rows)
+                {
+                    const auto nsPerSample = row.second / (static_cast<double> (numBlocks) * blockSize * numChannels);
+
+                    if (options.json)
+                        std::printf ("{\"mode\":\"%s\",\"layout\":\"%s\",\"channels\":%d,\"voices\":%d,\"block_size\":%d,"
+                                     "\"sample_rate\":%.0f,\"ns_per_channel_sample\":%.3f}\n",
+                                     row.first, layout.first, numChannels, voices, blockSize, sampleRate, nsPerSample);
+                    else
+                        std::printf ("%s,%s,%d,%d,%d,%.0f,%.3f\n", row.first, layout.first, numChannels, voices, blockSize, sampleRate, nsPerSample);
+                }
+
+                std::fflush (stdout);
+            }
+    }
+
+    // Error de un interpolador frente a un retardo fraccional ideal (analitico):
+    // seno a frequency Hz por un delay modulado D(n) = 480 + 5 sin(2 pi 0.8 n / sr).
+    // Se devuelve la energia de error (distorsion, imagenes y ruido) relativa a la senal, en dB
+    template <typename Interp>
+    double measureInterpolationError (double frequency, double sampleRate)
+    {
+        constexpr int W = Float4::width;
+        const int numSamples = static_cast<int> (sampleRate);
+        const int settle = 4096;   // transitorio inicial del allpass
+        const double twoPi = 6.283185307179586;
+
+        auto delayAt = [&] (int n) { return 480.0 + 5.0 * std::sin (twoPi * 0.8 * n / sampleRate); };
+        auto input = [&] (int n) { return 0.5 * std::sin (twoPi * frequency * n / sampleRate); };
+
+        // Historia intercalada como en el delay line (el mismo valor en los 4 carriles)
+        std::vector<float> history (static_cast<size_t> (numSamples * W));
+        for (int n = 0; n < numSamples; ++n)
+            for (int lane = 0; lane < W; ++lane)
+                history[(size_t) (n * W + lane)] = static_cast<float> (input (n));
+
+        alignas (16) float weights[ChorusEngine::maxTaps * W];
+        alignas (16) float output[W];
+        auto previous = Float4::broadcast (0.0f);
+        double errorEnergy = 0.0;
+        double signalEnergy = 0.0;
+
+        for (int n = 600; n < numSamples; ++n)
+        {
+            // Misma separacion que el plan del motor: idx1 = n - ceil(d), t = ceil(d) - d
+            const double delay = delayAt (n);
+            const int ceilDelay = static_cast<int> (delay) + 1;
+            const float t = static_cast<float> (ceilDelay - delay);
+            const int firstFrame = n - ceilDelay + Interp::firstTap;
+
+            Interp::computeWeights (Float4::broadcast (t), weights, W);
+            Interp::read (history.data() + firstFrame * W, weights, W, previous).store (output);
+
+            if (n >= settle)
+            {
+                const double ideal = 0.5 * std::sin (twoPi * frequency * (n - delay) / sampleRate);
+                errorEnergy += (output[0] - ideal) * (output[0] - ideal);
+                signalEnergy += ideal * ideal;
+            }
+        }
+
+        return 10.0 * std::log10 (std::max (errorEnergy, 1.0e-30) / signalEnergy);
+    }
+
+    // Velocidad y error de cada nivel de interpolacion
+    void runQualitySweep (const BenchOptions& options)
+    {
+        const double sampleRate = 48000.0;
+        const int blockSize = 512;
+        const int numBlocks = std::max (1, static_cast<int> (options.secondsPerRun * sampleRate / blockSize));
+        const double frequencies[] = { 1000.0, 5000.0, 10000.0, 15000.0 };
+
+        struct Tier
+        {
+            const char* name;
+            ChorusEngine::Interpolation interpolation;
+            double (*measure) (double, double);
+        };
+
+        const Tier tiers[] = {
+            { "linear",      ChorusEngine::Interpolation::linear,     measureInterpolationError<LinearInterpolator> },
+            { "catmull_rom", ChorusEngine::Interpolation::catmullRom, measureInterpolationError<CatmullRomInterpolator> },
+            { "lagrange6",   ChorusEngine::Interpolation::lagrange,   measureInterpolationError<LagrangeInterpolator> },
+            { "allpass",     ChorusEngine::Interpolation::allpass,    measureInterpolationError<AllpassInterpolator> },
+        };
+
+        if (! options.json)
+            std::printf ("interpolation,voices,ns_per_frame,error_db_1k,error_db_5k,error_db_10k,error_db_15k\n");
+
+        for (const auto& tier : tiers)
+        {
+            double errorDb[4];
+            for (int f = 0; f < 4; ++f)
+                errorDb[f] = tier.measure (frequencies[f], sampleRate);
+
+            for (int voices : { 1, 4 })
+            {
+                std::vector<float> left (blockSize), right (blockSize);
+                std::mt19937 rng (5);
+                std::uniform_real_distribution<float> dist (-0.25f, 0.25f);
+                for (int i = 0; i < blockSize; ++i)
+                {
+                    left[(size_t) i] = dist (rng);
+                    right[(size_t) i] = dist (rng);
+                }
+
+                ChorusEngine engine;
+                ChorusEngine::Parameters params;
+                params.voices = voices;
+                params.interpolation = tier.interpolation;
+                engine.setParameters (params);
+                engine.prepare (sampleRate, 2, blockSize);
+
+                std::vector<float> work0 (blockSize), work1 (blockSize);
+                float* channels[] = { work0.data(), work1.data() };
+
+                const auto ns = timeBlocks (numBlocks, options.repeats, [&]
+                {
+                    ScopedFlushDenormals noDenormals;
+                    std::copy (left.begin(), left.end(), work0.begin());
+                    std::copy (right.begin(), right.end(), work1.begin());
+                    engine.process (channels, 2, blockSize);
+                });
+
+                const auto nsPerFrame = ns / (static_cast<double> (numBlocks) * blockSize);
+
+                if (options.json)
+                    std::printf ("{\"interpolation\":\"%s\",\"voices\":%d,\"ns_per_frame\":%.3f,\"error_db_1k\":%.1f,"
+                                 "\"error_db_5k\":%.1f,\"error_db_10k\":%.1f,\"error_db_15k\":%.1f}\n",
+                                 tier.name, voices, nsPerFrame, errorDb[0], errorDb[1], errorDb[2], errorDb[3]);
+                else
+                    std::printf ("%s,%d,%.3f,%.1f,%.1f,%.1f,%.1f\n",
+                                 tier.name, voices, nsPerFrame, errorDb[0], errorDb[1], errorDb[2], errorDb[3]);
+
+                std::fflush (stdout);
+            }
+        }
+    }
+
+    bool sameParameters (const ChorusEngine::Parameters& a, const ChorusEngine::Parameters& b)
+    {
+        return a.rate == b.rate && a.depth == b.depth && a.mix == b.mix && a.voices == b.voices
+            && a.interpolation == b.interpolation;
+    }
+
+    // Ida y vuelta del estado binario: formato, compatibilidad y recall del procesador
+    // Fuerza al gobernador a bajar hasta el ultimo nivel (umbral casi cero) y a
+    // volver a subir (umbral alto), comprobando que los cambios no dejan clicks
+    int runGovernorCheck (const BenchOptions& options)
+    {
+        const double sampleRate = 48000.0;
+        const int blockSize = 256;
+        const double clickThreshold = 0.05;   // segunda diferencia; un cambio sin fundido da ~0.15
+
+        KoruzAudioProcessor processor;
+        juce::AudioProcessor::BusesLayout buses;
+        buses.inputBuses.add (juce::AudioChannelSet::stereo());
+        buses.outputBuses.add (juce::AudioChannelSet::stereo());
+        processor.setBusesLayout (buses);
+
+        setParameter (processor.getDepthParam(), 0.8f);
+        setParameter (processor.getMixParam(), 0.7f);
+        processor.getVoicesParam()->setValueNotifyingHost (1.0f);
+        *processor.getQualityParam() = 2;
+        processor.setGovernorEnabled (true);
+
+        processor.setRateAndBufferSizeDetails (sampleRate, blockSize);
+        processor.prepareToPlay (sampleRate, blockSize);
+
+        juce::AudioBuffer<float> buffer (2, blockSize);
+        juce::MidiBuffer midi;
+
+        // Fases: normal, sobrecarga simulada, margen de sobra
+        const std::pair<float, double> phases[] = { { 0.25f, 4.0 }, { 1.0e-6f, 6.0 }, { 1.0f, 16.0 } };
+
+        if (! options.json)
+            std::printf ("time_s,threshold,tier,load,max_d2\n");
+
+        juce::int64 position = 0;
+        float history[2][2] = {};
+        double worstD2 = 0.0;
+        int deepestTier = 0;
+        double reportTime = 0.0;
+        double reportD2 = 0.0;
+
+        for (const auto& phase : phases)
+        {
+            processor.setCpuBudgetThreshold (phase.first);
+            const auto numBlocks = static_cast<int> (phase.second * sampleRate / blockSize);
+
+            for (int b = 0; b < numBlocks; ++b)
+            {
+                for (int ch = 0; ch < 2; ++ch)
+                    for (int i = 0; i < blockSize; ++i)
+                        buffer.setSample (ch, i, 0.5f * static_cast<float> (std::sin (6.283185307179586 * 220.0 * static_cast<double> (position + i) / sampleRate)));
+
+                processor.processBlock (buffer, midi);
+                position += blockSize;
+
+                for (int ch = 0; ch < 2; ++ch)
+                    for (int i = 0; i < blockSize; ++i)
+                    {
+                        const float x = buffer.getSample (ch, i);
+                        reportD2 = std::max (reportD2, static_cast<double> (std::abs (x - 2.0f * history[ch][1] + history[ch][0])));
+                        history[ch][0] = history[ch][1];
+                        history[ch][1] = x;
+                    }
+
+                deepestTier = std::max (deepestTier, processor.getLoadTier());
+
+                const double time = static_cast<double> (position) / sampleRate;
+                if (time - reportTime >= 0.5)
+                {
+                    if (position > 2 * blockSize)
+                        worstD2 = std::max (worstD2, reportD2);
+
+                    if (options.json)
+                        std::printf ("{\"time_s\":%.2f,\"threshold\":%g,\"tier\":%d,\"load\":%.5f,\"max_d2\":%.5f}\n",
+                                     time, phase.first, processor.getLoadTier(), processor.getCpuLoad(), reportD2);
+                    else
+                        std::printf ("%.2f,%g,%d,%.5f,%.5f\n", time, phase.first, processor.getLoadTier(), processor.getCpuLoad(), reportD2);
+
+                    reportTime = time;
+                    reportD2 = 0.0;
+                }
+            }
+        }
+
+        processor.releaseResources();
+
+        const bool passed = deepestTier == CpuGovernor::maxTier && processor.getLoadTier() == 0 && worstD2 < clickThreshold;
+        std::printf ("governor: deepest tier %d, final tier %d, worst d2 %.5f: %s\n",
+                     deepestTier, processor.getLoadTier(), worstD2, passed ? "ok" : "FAILED");
+        return passed ? 0 : 1;
+    }
+
+    int runStateCheck (const BenchOptions& options)
+    {
+        int failures = 0;
+        auto check = [&failures] (bool condition, const char* what)
+        {
+            if (! condition)
+            {
+                std::printf ("FAIL: %s\n", what);
+                ++failures;
+            }
+        };
+
+        std::mt19937 rng (7);
+        std::uniform_real_distribution<float> unit (0.0f, 1.0f);
+        std::array<std::uint8_t, ChorusState::maxSize + 16> bytes {};
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            ChorusState written;
+            written.parameters.rate = 0.1f + 1.9f * unit (rng);
+            written.parameters.depth = unit (rng);
+            written.parameters.mix = unit (rng);
+            written.parameters.voices = 1 + i % ChorusEngine::maxVoices;
+            written.parameters.interpolation = static_cast<ChorusEngine::Interpolation> (i % 4);
+            written.clipOversampling = (i % 3) != 0;
+            written.cpuGovernor = (i % 2) != 0;
+            written.hasLfoPhase = (i % 2) == 0;
+            written.lfoPhase = unit (rng);
+
+            const auto size = written.write (bytes.data(), ChorusState::maxSize);
+            ChorusState read;
+            check (size > 0 && read.read (bytes.data(), size), "round trip read");
+            check (sameParameters (read.parameters, written.parameters), "round trip parameters");
+            check (read.clipOversampling == written.clipOversampling, "round trip clip oversampling");
+            check (read.cpuGovernor == written.cpuGovernor, "round trip cpu governor");
+            check (read.hasLfoPhase == written.hasLfoPhase && (! read.hasLfoPhase || read.lfoPhase == written.lfoPhase), "round trip LFO phase");
+
+            // Truncado: se rechaza y no cambia nada
+            ChorusState untouched;
+            check (! untouched.read (bytes.data(), size - 1) && sameParameters (untouched.parameters, ChorusEngine::Parameters()), "truncated state rejected");
+        }
+
+        // Hacia delante: un campo desconocido de una version futura se ignora
+        {
+            ChorusState written;
+            written.parameters.mix = 0.25f;
+            auto size = written.write (bytes.data(), bytes.size());
+            const std::uint8_t extraField[] = { 0xe7, 0x03, 0x04, 0x00, 1, 2, 3, 4 };
+            std::memcpy (bytes.data() + size, extraField, sizeof (extraField));
+            size += sizeof (extraField);
+            bytes[6] = static_cast<std::uint8_t> (bytes[6] + 1);
+
+            ChorusState read;
+            check (read.read (bytes.data(), size) && sameParameters (read.parameters, written.parameters), "unknown field skipped");
+        }
+
+        // Hacia atras: un estado antiguo sin voces deja el valor por defecto
+        {
+            const std::uint8_t oldState[] = { 'K', 'R', 'Z', 'S', 1, 0, 1, 0, 3, 0, 4, 0, 0x00, 0x00, 0x80, 0x3e };
+            ChorusState read;
+            check (read.read (oldState, sizeof (oldState)) && read.parameters.mix == 0.25f
+                       && read.parameters.voices == ChorusEngine::Parameters().voices, "missing fields keep defaults");
+        }
+
+        // Corrupto: lo no finito se rechaza sin tocar nada, el resto se lleva al rango
+        {
+            const float nan = std::numeric_limits<float>::quiet_NaN();
+            const double inf = std::numeric_limits<double>::infinity();
+
+            auto corrupted = [&bytes] (float rate, float depth, int voices, bool hasLfoPhase, double lfoPhase)
+            {
+                ChorusState written;
+                written.parameters.rate = rate;
+                written.parameters.depth = depth;
+                written.parameters.voices = voices;
+                written.hasLfoPhase = hasLfoPhase;
+                written.lfoPhase = lfoPhase;
+                return written.write (bytes.data(), bytes.size());
+            };
+
+            ChorusState untouched;
+            check (! untouched.read (bytes.data(), corrupted (nan, 0.5f, 2, false, 0.0))
+                       && sameParameters (untouched.parameters, ChorusEngine::Parameters()), "NaN rate rejected");
+            check (! untouched.read (bytes.data(), corrupted (1.0f, 0.5f, 2, true, inf))
+                       && ! untouched.hasLfoPhase && sameParameters (untouched.parameters, ChorusEngine::Parameters()), "infinite LFO phase rejected");
+
+            ChorusState read;
+            check (read.read (bytes.data(), corrupted (50.0f, -3.0f, 1000, true, 7.25))
+                       && read.parameters.rate == ChorusState::maxRate && read.parameters.depth == 0.0f
+                       && read.parameters.voices == ChorusEngine::maxVoices && read.lfoPhase == 0.25, "out of range values clamped");
+            check (read.read (bytes.data(), corrupted (0.0f, 0.5f, -5, true, -0.25))
+                       && read.parameters.rate == ChorusState::minRate && read.parameters.voices == 1
+                       && read.lfoPhase == 0.75, "negative values clamped and LFO phase wrapped");
+        }
+
+        // Recall completo a traves del procesador
+        {
+            KoruzAudioProcessor source;
+            setParameter (source.getRateParam(), 1.37f);
+            setParameter (source.getDepthParam(), 0.81f);
+            setParameter (source.getMixParam(), 0.33f);
+            source.getVoicesParam()->setValueNotifyingHost (source.getVoicesParam()->convertTo0to1 (5.0f));
+            *source.getQualityParam() = 2;
+            *source.getClipOversamplingParam() = true;
+            *source.getCpuGovernorParam() = true;
+
+            juce::MemoryBlock block;
+            source.getStateInformation (block);
+
+            KoruzAudioProcessor restored;
+            restored.setStateInformation (block.getData(), static_cast<int> (block.getSize()));
+
+            check (restored.getRateParam()->get() == source.getRateParam()->get()
+                       && restored.getDepthParam()->get() == source.getDepthParam()->get()
+                       && restored.getMixParam()->get() == source.getMixParam()->get()
+                       && restored.getVoicesParam()->get() == source.getVoicesParam()->get()
+                       && restored.getQualityParam()->getIndex() == source.getQualityParam()->getIndex()
+                       && restored.getClipOversamplingParam()->get() == source.getClipOversamplingParam()->get()
+                       && restored.getCpuGovernorParam()->get() == source.getCpuGovernorParam()->get(), "processor recall");
+
+            // Tiempo de carga de una sesion grande (sin contar la creacion de instancias)
+            const int numInstances = 500;
+            std::vector<std::unique_ptr<KoruzAudioProcessor>> session;
+            for (int i = 0; i < numInstances; ++i)
+                session.push_back (std::make_unique<KoruzAudioProcessor>());
+
+            const auto loadNs = timeBlocks (1, options.repeats, [&]
+            {
+                for (auto& instance : session)
+                    instance->setStateInformation (block.getData(), static_cast<int> (block.getSize()));
+            });
+
+            std::printf ("state: %d bytes, %d instances restored in %.3f ms\n",
+                         static_cast<int> (block.getSize()), numInstances, loadNs * 1.0e-6);
+        }
+
+        std::printf ("state: %s\n", failures == 0 ? "ok" : "FAILED");
+        return failures == 0 ? 0 : 1;
+    }
+
+    // Memoria por instancia en sesiones de distinto tamano; el workspace compartido se cuenta una vez
+    int runMemoryReport (const BenchOptions& options)
+    {
+        const double sampleRate = 48000.0;
+        const int blockSize = 512;
+        int failures = 0;
+
+        // Lo que cada motor llevaba antes en su arena en lugar del workspace pequeno
+        const auto movedBytes = ChorusWorkspace::getRequiredBytes (ChorusWorkspacePool::chunkFrames)
+                              - ChorusWorkspace::getRequiredBytes (ChorusEngine::fallbackChunkFrames);
+
+        if (! options.json)
+            std::printf ("instances,instance_bytes,shared_bytes,sharing_engines,total_bytes,bytes_per_instance,unshared_bytes_per_instance\n");
+
+        for (int numInstances : { 1, 10, 100, 500 })
+        {
+            std::vector<std::unique_ptr<KoruzAudioProcessor>> session;
+            for (int i = 0; i < numInstances; ++i)
+            {
+                session.push_back (std::make_unique<KoruzAudioProcessor>());
+                session.back()->setRateAndBufferSizeDetails (sampleRate, blockSize);
+                session.back()->prepareToPlay (sampleRate, blockSize);
+            }
+
+            const auto usage = session.front()->getMemoryUsage();
+            const auto totalBytes = usage.instanceBytes * static_cast<size_t> (numInstances) + usage.sharedBytes;
+            const auto perInstance = static_cast<double> (totalBytes) / numInstances;
+            const auto unsharedPerInstance = usage.instanceBytes + movedBytes;
+
+            if (usage.sharingEngines != numInstances || usage.sharedBytes == 0)
+            {
+                std::printf ("FAIL: %d instances share a workspace of %d bytes among %d engines\n",
+                             numInstances, static_cast<int> (usage.sharedBytes), usage.sharingEngines);
+                ++failures;
+            }
+
+            // El arena se dimensiona por el layout anunciado (stereo), no por el mayor aceptado
+            const auto layoutBytes = sizeof (KoruzAudioProcessor) + ChorusEngine::getRequiredBytes (sampleRate, 2);
+            if (usage.instanceBytes > layoutBytes)
+            {
+                std::printf ("FAIL: a stereo instance owns %zu bytes, its layout needs %zu\n", usage.instanceBytes, layoutBytes);
+                ++failures;
+            }
+
+            if (options.json)
+                std::printf ("{\"instances\":%d,\"instance_bytes\":%zu,\"shared_bytes\":%zu,\"sharing_engines\":%d,"
+                             "\"total_bytes\":%zu,\"bytes_per_instance\":%.0f,\"unshared_bytes_per_instance\":%zu}\n",
+                             numInstances, usage.instanceBytes, usage.sharedBytes, usage.sharingEngines,
+                             totalBytes, perInstance, unsharedPerInstance);
+            else
+                std::printf ("%d,%zu,%zu,%d,%zu,%.0f,%zu\n",
+                             numInstances, usage.instanceBytes, usage.sharedBytes, usage.sharingEngines,
+                             totalBytes, perInstance, unsharedPerInstance);
+        }
+
+        // Con la sesion destruida el pool tiene que haberse liberado
+        if (ChorusWorkspacePool::getNumUsers() != 0 || ChorusWorkspacePool::getSharedBytes() != 0)
+        {
+            std::printf ("FAIL: shared workspace still alive with no instances\n");
+            ++failures;
+        }
+
+        if (! options.json)
+            std::printf ("memory: %s\n", failures == 0 ? "ok" : "FAILED");
+
+        return failures == 0 ? 0 : 1;
+    }
+
+    void printUsage()
+    {
+        std::printf ("Usage: KoruzBenchmark [--json] [--quick] [--batch] [--quality] [--double] [--surround] [--state] [--memory] [--verify] [--trace <file>] [--seconds <s>] [--repeats <n>]\n"
+                     "  --json       emit JSON lines instead of CSV\n"
+                     "  --batch      compare N separate mono engines against one ChorusBatch\n"
+                     "  --quality    speed and error against an ideal fractional delay for each interpolation tier\n"
+                     "  --double     compare a float plugin in a 64-bit host (converted) against processBlock<double>\n"
+                     "  --surround   one 5.1/7.1/7.1.4 bed against one stereo instance per channel pair\n"
+                     "  --governor   drive the CPU governor down to its last tier and back, checking for clicks\n"
+                     "  --verify     optimized kernels and engine against the scalar reference (ChorusReference)\n"
+                     "  --state      check the binary state round trip and time a 500-instance recall\n"
+                     "  --memory     per-instance and shared memory for 1, 10, 100 and 500 stereo instances\n"
+                     "  --trace      write the run's processBlock/prepareToPlay trace as Chrome trace JSON (KORUZ_TRACE builds)\n"
+                     "  --quick      reduced sweep (3 block sizes, 2 sample rates)\n"
+                     "  --seconds    audio seconds processed per run (default 2)\n"
+                     "  --repeats    runs per configuration, best is reported (default 3)\n");
+    }
+
+    // Modo elegido en la linea de comandos (por defecto, el barrido de processBlock)
+    int runSelectedMode (const BenchOptions& options)
+    {
+        if (options.verify)
+            return runChorusVerification (options.quick, options.json) == 0 ? 0 : 1;
+
+        if (options.state)
+            return runStateCheck (options);
+
+        if (options.memory)
+            return runMemoryReport (options);
+
+        if (options.governor)
+            return runGovernorCheck (options);
+
+        if (options.quality)
+        {
+            runQualitySweep (options);
+            return 0;
+        }
+
+        if (options.doublePrecision)
+        {
+            runDoubleSweep (options);
+            return 0;
+        }
+
+        if (options.surround)
+        {
+            runSurroundSweep (options);
+            return 0;
+        }
+
+        if (options.batch)
+        {
+            runBatchSweep (options);
+            return 0;
+        }
+
+        std::vector<int> blockSizes { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+        std::vector<double> sampleRates { 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 };
+        const std::vector<int> channelCounts { 1, 2 };
+        const std::vector<std::pair<float, float>> depthMix { { 0.0f, 0.0f }, { 0.4f, 0.5f }, { 1.0f, 1.0f } };
+
+        if (options.quick)
+        {
+            blockSizes = { 32, 512, 4096 };
+            sampleRates = { 48000.0, 192000.0 };
+        }
+
+        printHeader (options);
+
+        for (auto sampleRate : sampleRates)
+            for (auto blockSize : blockSizes)
+                for (auto numChannels : channelCounts)
+                    for (const auto& dm : depthMix)
+                    {
+                        BenchConfig config;
+                        config.blockSize = blockSize;
+                        config.sampleRate = sampleRate;
+                        config.numChannels = numChannels;
+                        config.depth = dm.first;
+                        config.mix = dm.second;
+
+                        printResult (config, runConfig (config, options), options);
+                    }
+
+        return 0;
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    BenchOptions options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg (argv[i]);
+
+        if (arg == "--json")
+            options.json = true;
+        else if (arg == "--quick")
+            options.quick = true;
+        else if (arg == "--batch")
+            options.batch = true;
+        else if (arg == "--state")
+            options.state = true;
+        else if (arg == "--double")
+            options.doublePrecision = true;
+        else if (arg == "--quality")
+            options.quality = true;
+        else if (arg == "--governor")
+            options.governor = true;
+        else if (arg == "--verify")
+            options.verify = true;
+        else if (arg == "--surround")
+            options.surround = true;
+        else if (arg == "--memory")
+            options.memory = true;
+        else if (arg == "--trace" && i + 1 < argc)
+            options.tracePath = argv[++i];
+        else if (arg == "--seconds" && i + 1 < argc)
+            options.secondsPerRun = std::max (0.01, std::atof (argv[++i]));
+        else if (arg == "--repeats" && i + 1 < argc)
+            options.repeats = std::max (1, std::atoi (argv[++i]));
+        else
+        {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    if (! options.tracePath.empty() && ! KoruzTrace::enabled)
+    {
+        std::fprintf (stderr, "--trace needs a build configured with -DKORUZ_TRACE=ON\n");
+        return 1;
+    }
+
+    const int result = runSelectedMode (options);
+
+    // Ultimos eventos de cada hilo (el anillo guarda unos segundos): ui.perfetto.dev o chrome://tracing
+    if (! options.tracePath.empty())
+    {
+        if (! KoruzTrace::writeChromeTrace (options.tracePath.c_str()))
+        {
+            std::fprintf (stderr, "could not write %s\n", options.tracePath.c_str());
+            return 1;
+        }
+
+        std::fprintf (stderr, "trace written to %s\n", options.tracePath.c_str());
+    }
+
+    return result;
+}
@@ -0,0 +1,735 @@
+#include "ChorusEngine.h"
+#include "ChorusState.h"
+#include "KoruzTrace.h"
+#include <clap/clap.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#ifndef KORUZ_VERSION
+ #define KORUZ_VERSION "1.0.0"
+#endif
+
+// Koruz como plugin CLAP, directamente sobre el nucleo DSP (sin JUCE).
+// - Parametros sample-accurate: el bloque se parte en el instante de cada evento
+//   y cada tramo se procesa con los valores vigentes (las rampas de 20ms del motor
+//   arrancan en ese sample, no al principio del bloque).
+// - Sin thread-pool en el host todos los canales van en un solo motor, como en el
+//   VST3. Con thread-pool se reparten en motores de sliceChannels (un grupo Float4
+//   cada uno) y cada tramo se reparte entre los hilos del host; cada motor solo lo
+//   toca un hilo a la vez. Las voces de un canal no se reparten: leen del mismo
+//   delay line en una sola pasada SIMD.
+// - Cada motor lleva su propio LFO y su propia deteccion de silencio: un grupo en
+//   silencio pasa a reposo aunque los demas sigan. Los LFO arrancan juntos en
+//   activate sobre la misma rejilla y el reposo los avanza con la misma recursion,
+//   asi que siguen en fase al retomar.
+// - Mismo estado binario (ChorusState) que el VST3, con el modo de la rodilla a 2x:
+//   no es un parametro (cambia la latencia), llega con el estado y entra en el
+//   siguiente activate.
+namespace
+{
+    enum ParamId : clap_id
+    {
+        rateId,
+        depthId,
+        mixId,
+        voicesId,
+        qualityId,
+        numParams
+    };
+
+    struct ParamSpec
+    {
+        const char* name;
+        double minValue;
+        double maxValue;
+        double defaultValue;
+        bool stepped;
+    };
+
+    // Mismos rangos y valores por defecto que KoruzAudioProcessor; los ids no se renumeran
+    const ParamSpec paramSpecs[numParams] =
+    {
+        { "Rate",    ChorusState::minRate, ChorusState::maxRate, 0.8, false },
+        { "Depth",   0.0, 1.0, 0.4, false },
+        { "Mix",     0.0, 1.0, 0.5, false },
+        { "Voices",  1.0, ChorusEngine::maxVoices, 1.0, true },
+        { "Quality", 0.0, 2.0, 1.0, true }
+    };
+
+    const char* const qualityNames[] = { "Eco", "Normal", "HQ" };
+
+    // Configuraciones de puertos: entrada y salida iguales. Sin mapa de canales,
+    // en surround el orden es el del host (el desfase del LFO solo depende del indice)
+    struct PortConfig
+    {
+        const char* name;
+        uint32_t numChannels;
+        const char* portType;
+    };
+
+    const PortConfig portConfigs[] =
+    {
+        { "Stereo", 2,  CLAP_PORT_STEREO },
+        { "Mono",   1,  CLAP_PORT_MONO },
+        { "5.1",    6,  nullptr },
+        { "7.1",    8,  nullptr },
+        { "7.1.4",  12, nullptr }
+    };
+
+    constexpr uint32_t numPortConfigs = sizeof (portConfigs) / sizeof (portConfigs[0]);
+
+    const char* const features[] =
+    {
+        CLAP_PLUGIN_FEATURE_AUDIO_EFFECT,
+        CLAP_PLUGIN_FEATURE_CHORUS,
+        CLAP_PLUGIN_FEATURE_MONO,
+        CLAP_PLUGIN_FEATURE_STEREO,
+        CLAP_PLUGIN_FEATURE_SURROUND,
+        nullptr
+    };
+
+    const clap_plugin_descriptor_t descriptor =
+    {
+        CLAP_VERSION_INIT,
+        "com.davidsignals.koruz",
+        "Koruz",
+        "DavidSignals",
+        "https://github.com/davidsignalsss/koruz",
+        "",
+        "",
+        KORUZ_VERSION,
+        "Analog-style chorus",
+        features
+    };
+
+    ChorusEngine::Interpolation qualityToInterpolation (int qualityIndex)
+    {
+        switch (qualityIndex)
+        {
+            case 0:  return ChorusEngine::Interpolation::linear;
+            case 2:  return ChorusEngine::Interpolation::lagrange;
+            default: return ChorusEngine::Interpolation::catmullRom;
+        }
+    }
+
+    class KoruzClap
+    {
+    public:
+        static constexpr int sliceChannels = 4;
+        static constexpr int maxSlices = ChorusEngine::maxChannels / sliceChannels;
+
+        // Tramos mas cortos no compensan despertar a los hilos del host
+        static constexpr uint32_t minPooledFrames = 32;
+
+        explicit KoruzClap (const clap_host_t* clapHost)
+            : host (clapHost)
+        {
+            plugin.desc = &descriptor;
+            plugin.plugin_data = this;
+            plugin.init = [] (const clap_plugin_t* p) { return from (p).init(); };
+            plugin.destroy = [] (const clap_plugin_t* p) { delete &from (p); };
+            plugin.activate = [] (const clap_plugin_t* p, double sampleRate, uint32_t, uint32_t maxFrames)
+            {
+                return from (p).activate (sampleRate, maxFrames);
+            };
+            plugin.deactivate = [] (const clap_plugin_t* p) { from (p).deactivate(); };
+            plugin.start_processing = [] (const clap_plugin_t*) { return true; };
+            plugin.stop_processing = [] (const clap_plugin_t*) {};
+            plugin.reset = [] (const clap_plugin_t* p) { from (p).reset(); };
+            plugin.process = [] (const clap_plugin_t* p, const clap_process_t* process) { return from (p).process (*process); };
+            plugin.get_extension = [] (const clap_plugin_t*, const char* id) { return getExtension (id); };
+            plugin.on_main_thread = [] (const clap_plugin_t*) {};
+
+            for (clap_id id = 0; id < numParams; ++id)
+                values[id].store (paramSpecs[id].defaultValue, std::memory_order_relaxed);
+        }
+
+        ~KoruzClap()
+        {
+            KoruzTrace::releaseRing (traceRing);
+            for (auto* ring : sliceTraceRings)
+                KoruzTrace::releaseRing (ring);
+        }
+
+        const clap_plugin_t* getPlugin() const { return &plugin; }
+
+    private:
+        static KoruzClap& from (const clap_plugin_t* p) { return *static_cast<KoruzClap*> (p->plugin_data); }
+
+        bool init()
+        {
+            hostParams = static_cast<const clap_host_params_t*> (host->get_extension (host, CLAP_EXT_PARAMS));
+            hostThreadPool = static_cast<const clap_host_thread_pool_t*> (host->get_extension (host, CLAP_EXT_THREAD_POOL));
+            hostLatency = static_cast<const clap_host_latency_t*> (host->get_extension (host, CLAP_EXT_LATENCY));
+            traceRing = KoruzTrace::claimRing (this);
+            return true;
+        }
+
+        // HILO PRINCIPAL - aqui si se reserva memoria
+        bool activate (double sampleRate, uint32_t maxFrames)
+        {
+            KORUZ_TRACE_SCOPE (traceRing, "activate");
+
+            currentSampleRate = sampleRate;
+            channelsPerSlice = hostThreadPool != nullptr ? sliceChannels : numChannels;
+            numSlices = (numChannels + channelsPerSlice - 1) / channelsPerSlice;
+
+            float phaseOffsets[ChorusEngine::maxChannels];
+            for (int ch = 0; ch < ChorusEngine::maxChannels; ++ch)
+                phaseOffsets[ch] = ChorusEngine::getLayoutPhaseOffset (ch, numChannels);
+
+            const auto parameters = getParameters();
+
+            for (int s = 0; s < numSlices; ++s)
+            {
+                // Cada tramo puede ir en otro hilo del pool: un anillo por tramo
+                if (sliceTraceRings[s] == nullptr)
+                    sliceTraceRings[s] = KoruzTrace::claimRing (this);
+
+                auto& engine = engines[s];
+                engine.setTraceRing (sliceTraceRings[s]);
+                engine.setParameters (parameters);
+                engine.setTailLength (tailSeconds);
+                engine.setClipOversampling (clipOversampling);
+                engine.setChannelPhaseOffsets (phaseOffsets + s * channelsPerSlice, getSliceChannels (s));
+                engine.prepare (sampleRate, getSliceChannels (s), static_cast<int> (maxFrames));
+            }
+
+            parametersChanged.store (false, std::memory_order_relaxed);
+
+            // La latencia solo se puede anunciar dentro de activate
+            if (latencyChanged && hostLatency != nullptr)
+                hostLatency->changed (host);
+
+            latencyChanged = false;
+            return true;
+        }
+
+        void deactivate()
+        {
+            for (auto& engine : engines)
+                engine.release();
+
+            numSlices = 0;
+        }
+
+        void reset()
+        {
+            for (int s = 0; s < numSlices; ++s)
+                engines[s].reset();
+        }
+
+        int getLatencySamples() const { return clipOversampling ? OversampledClipper::latencySamples : 0; }
+
+        int getSliceChannels (int slice) const
+        {
+            return std::min (channelsPerSlice, numChannels - slice * channelsPerSlice);
+        }
+
+        ChorusEngine::Parameters getParameters() const
+        {
+            ChorusEngine::Parameters parameters;
+            parameters.rate = static_cast<float> (values[rateId].load (std::memory_order_relaxed));
+            parameters.depth = static_cast<float> (values[depthId].load (std::memory_order_relaxed));
+            parameters.mix = static_cast<float> (values[mixId].load (std::memory_order_relaxed));
+            parameters.voices = static_cast<int> (values[voicesId].load (std::memory_order_relaxed));
+            parameters.interpolation = qualityToInterpolation (static_cast<int> (values[qualityId].load (std::memory_order_relaxed)));
+            return parameters;
+        }
+
+        // std::min/std::max dejan pasar NaN: un valor no finito vuelve al de por defecto
+        static double clampValue (clap_id id, double value)
+        {
+            const auto& spec = paramSpecs[id];
+            if (! std::isfinite (value))
+                return spec.defaultValue;
+
+            value = std::min (std::max (value, spec.minValue), spec.maxValue);
+            return spec.stepped ? std::round (value) : value;
+        }
+
+        // Devuelve true si el evento cambia algun parametro
+        bool handleEvent (const clap_event_header_t& header)
+        {
+            if (header.space_id != CLAP_CORE_EVENT_SPACE_ID || header.type != CLAP_EVENT_PARAM_VALUE)
+                return false;
+
+            const auto& event = reinterpret_cast<const clap_event_param_value_t&> (header);
+            if (event.param_id >= numParams || ! std::isfinite (event.value))
+                return false;
+
+            values[event.param_id].store (clampValue (event.param_id, event.value), std::memory_order_relaxed);
+            return true;
+        }
+
+        void flushParameters (const clap_input_events_t& in)
+        {
+            bool changed = false;
+            const uint32_t numEvents = in.size (&in);
+            for (uint32_t i = 0; i < numEvents; ++i)
+                changed = handleEvent (*in.get (&in, i)) || changed;
+
+            if (changed)
+                parametersChanged.store (true, std::memory_order_release);
+        }
+
+        // HILO DE AUDIO
+        clap_process_status process (const clap_process_t& process)
+        {
+            KORUZ_TRACE_SCOPE (traceRing, "clap process");
+
+            const auto& in = *process.in_events;
+            const uint32_t numEvents = in.size (&in);
+            const uint32_t numFrames = process.frames_count;
+            bool changed = parametersChanged.exchange (false, std::memory_order_acquire);
+
+            if (process.audio_outputs_count == 0 || numSlices == 0)
+            {
+                flushParameters (in);
+                return CLAP_PROCESS_CONTINUE;
+            }
+
+            if (hasPendingLfoPhase.exchange (false, std::memory_order_acquire))
+                for (int s = 0; s < numSlices; ++s)
+                    engines[s].setLfoPhase (pendingLfoPhase.load (std::memory_order_relaxed));
+
+            // ENTRADA - el motor trabaja in-place sobre la salida
+            const auto& output = process.audio_outputs[0];
+            const auto* input = process.audio_inputs_count > 0 ? &process.audio_inputs[0] : nullptr;
+            const int channelsToProcess = std::min (numChannels, static_cast<int> (output.channel_count));
+
+            job.data32 = output.data32;
+            job.data64 = output.data32 == nullptr ? output.data64 : nullptr;
+            job.numChannels = channelsToProcess;
+
+            if (job.data64 != nullptr)
+                copyInput (input != nullptr ? input->data64 : nullptr, input != nullptr ? input->channel_count : 0, job.data64, numFrames);
+            else
+                copyInput (input != nullptr ? input->data32 : nullptr, input != nullptr ? input->channel_count : 0, job.data32, numFrames);
+
+            // EVENTOS - cada tramo llega hasta el siguiente evento; los eventos de un
+            // mismo instante se aplican juntos antes de su tramo
+            uint32_t next = 0;
+            for (uint32_t frame = 0; frame < numFrames;)
+            {
+                for (; next < numEvents; ++next)
+                {
+                    const auto* header = in.get (&in, next);
+                    if (header->time > frame)
+                        break;
+
+                    changed = handleEvent (*header) || changed;
+                }
+
+                const uint32_t end = next < numEvents ? std::min (numFrames, in.get (&in, next)->time) : numFrames;
+
+                if (changed)
+                {
+                    const auto parameters = getParameters();
+                    for (int s = 0; s < numSlices; ++s)
+                        engines[s].setParameters (parameters);
+
+                    changed = false;
+                }
+
+                processRange (frame, end - frame);
+                frame = end;
+            }
+
+            // Eventos fuera del bloque (o bloque vacio): cuentan para el siguiente
+            for (; next < numEvents; ++next)
+                changed = handleEvent (*in.get (&in, next)) || changed;
+
+            if (changed)
+                parametersChanged.store (true, std::memory_order_release);
+
+            return CLAP_PROCESS_CONTINUE;
+        }
+
+        template <typename SampleType>
+        void copyInput (SampleType* const* source, uint32_t numSourceChannels, SampleType* const* dest, uint32_t numFrames) const
+        {
+            for (int ch = 0; ch < job.numChannels; ++ch)
+            {
+                if (source == nullptr || static_cast<uint32_t> (ch) >= numSourceChannels)
+                    std::fill (dest[ch], dest[ch] + numFrames, SampleType (0));
+                else if (source[ch] != dest[ch])
+                    std::copy (source[ch], source[ch] + numFrames, dest[ch]);
+            }
+        }
+
+        void processRange (uint32_t offset, uint32_t numFrames)
+        {
+            job.offset = offset;
+            job.numFrames = numFrames;
+
+            // request_exec devuelve false si el host no puede ahora: se hace aqui
+            if (numSlices > 1 && numFrames >= minPooledFrames && hostThreadPool != nullptr
+                 && hostThreadPool->request_exec (host, static_cast<uint32_t> (numSlices)))
+                return;
+
+            for (int s = 0; s < numSlices; ++s)
+                processSlice (s);
+        }
+
+        // Hilo de audio o hilo del pool del host
+        void processSlice (int slice)
+        {
+            KORUZ_TRACE_SCOPE (sliceTraceRings[slice], "slice");
+
+            const int first = slice * channelsPerSlice;
+            const int count = std::min (channelsPerSlice, job.numChannels - first);
+            if (count <= 0)
+                return;
+
+            if (job.data64 != nullptr)
+                processSlice (engines[slice], job.data64 + first, count);
+            else
+                processSlice (engines[slice], job.data32 + first, count);
+        }
+
+        template <typename SampleType>
+        void processSlice (ChorusEngine& engine, SampleType* const* channels, int count) const
+        {
+            SampleType* range[ChorusEngine::maxChannels];
+            for (int ch = 0; ch < count; ++ch)
+                range[ch] = channels[ch] + job.offset;
+
+            engine.process (range, count, static_cast<int> (job.numFrames));
+        }
+
+        // EXTENSIONES
+        static const void* getExtension (const char* id)
+        {
+            static const clap_plugin_params_t params =
+            {
+                [] (const clap_plugin_t*) -> uint32_t { return numParams; },
+                [] (const clap_plugin_t*, uint32_t index, clap_param_info_t* info)
+                {
+                    if (index >= numParams)
+                        return false;
+
+                    const auto& spec = paramSpecs[index];
+                    *info = {};
+                    info->id = index;
+                    info->flags = CLAP_PARAM_IS_AUTOMATABLE;
+                    if (spec.stepped)
+                        info->flags |= CLAP_PARAM_IS_STEPPED;
+                    if (index == qualityId)
+                        info->flags |= CLAP_PARAM_IS_ENUM;
+
+                    std::snprintf (info->name, sizeof (info->name), "%s", spec.name);
+                    info->min_value = spec.minValue;
+                    info->max_value = spec.maxValue;
+                    info->default_value = spec.defaultValue;
+                    return true;
+                },
+                [] (const clap_plugin_t* p, clap_id id, double* value)
+                {
+                    if (id >= numParams)
+                        return false;
+
+                    *value = from (p).values[id].load (std::memory_order_relaxed);
+                    return true;
+                },
+                [] (const clap_plugin_t*, clap_id id, double value, char* text, uint32_t capacity)
+                {
+                    return id < numParams && valueToText (id, value, text, capacity);
+                },
+                [] (const clap_plugin_t*, clap_id id, const char* text, double* value)
+                {
+                    return id < numParams && textToValue (id, text, *value);
+                },
+                [] (const clap_plugin_t* p, const clap_input_events_t* in, const clap_output_events_t*)
+                {
+                    from (p).flushParameters (*in);
+                }
+            };
+
+            static const clap_plugin_audio_ports_t audioPorts =
+            {
+                [] (const clap_plugin_t*, bool) -> uint32_t { return 1; },
+                [] (const clap_plugin_t* p, uint32_t index, bool isInput, clap_audio_port_info_t* info)
+                {
+                    if (index != 0)
+                        return false;
+
+                    const auto& config = portConfigs[from (p).portConfig];
+                    *info = {};
+                    info->id = 0;
+                    std::snprintf (info->name, sizeof (info->name), "%s", isInput ? "Input" : "Output");
+                    info->flags = CLAP_AUDIO_PORT_IS_MAIN | CLAP_AUDIO_PORT_SUPPORTS_64BITS | CLAP_AUDIO_PORT_REQUIRES_COMMON_SAMPLE_SIZE;
+                    info->channel_count = config.numChannels;
+                    info->port_type = config.portType;
+                    info->in_place_pair = 0;
+                    return true;
+                }
+            };
+
+            static const clap_plugin_audio_ports_config_t audioPortsConfig =
+            {
+                [] (const clap_plugin_t*) { return numPortConfigs; },
+                [] (const clap_plugin_t*, uint32_t index, clap_audio_ports_config_t* config)
+                {
+                    if (index >= numPortConfigs)
+                        return false;
+
+                    const auto& ports = portConfigs[index];
+                    *config = {};
+                    config->id = index;
+                    std::snprintf (config->name, sizeof (config->name), "%s", ports.name);
+                    config->input_port_count = 1;
+                    config->output_port_count = 1;
+                    config->has_main_input = true;
+                    config->main_input_channel_count = ports.numChannels;
+                    config->main_input_port_type = ports.portType;
+                    config->has_main_output = true;
+                    config->main_output_channel_count = ports.numChannels;
+                    config->main_output_port_type = ports.portType;
+                    return true;
+                },
+                // Solo con el plugin desactivado: el siguiente activate prepara los motores
+                [] (const clap_plugin_t* p, clap_id configId)
+                {
+                    auto& self = from (p);
+                    if (configId >= numPortConfigs || self.numSlices > 0)
+                        return false;
+
+                    self.portConfig = configId;
+                    self.numChannels = static_cast<int> (portConfigs[configId].numChannels);
+                    return true;
+                }
+            };
+
+            // Filtros de la rodilla a 2x (o nada sin ella); no depende del sample rate
+            static const clap_plugin_latency_t latency =
+            {
+                [] (const clap_plugin_t* p) { return static_cast<uint32_t> (from (p).getLatencySamples()); }
+            };
+
+            static const clap_plugin_tail_t tail =
+            {
+                [] (const clap_plugin_t* p)
+                {
+                    return static_cast<uint32_t> (std::ceil (from (p).currentSampleRate * tailSeconds) + from (p).getLatencySamples());
+                }
+            };
+
+            static const clap_plugin_state_t state =
+            {
+                [] (const clap_plugin_t* p, const clap_ostream_t* stream) { return from (p).saveState (*stream); },
+                [] (const clap_plugin_t* p, const clap_istream_t* stream) { return from (p).loadState (*stream); }
+            };
+
+            static const clap_plugin_thread_pool_t threadPool =
+            {
+                [] (const clap_plugin_t* p, uint32_t task) { from (p).processSlice (static_cast<int> (task)); }
+            };
+
+            if (std::strcmp (id, CLAP_EXT_PARAMS) == 0)             return &params;
+            if (std::strcmp (id, CLAP_EXT_AUDIO_PORTS) == 0)        return &audioPorts;
+            if (std::strcmp (id, CLAP_EXT_AUDIO_PORTS_CONFIG) == 0) return &audioPortsConfig;
+            if (std::strcmp (id, CLAP_EXT_LATENCY) == 0)            return &latency;
+            if (std::strcmp (id, CLAP_EXT_TAIL) == 0)               return &tail;
+            if (std::strcmp (id, CLAP_EXT_STATE) == 0)              return &state;
+            if (std::strcmp (id, CLAP_EXT_THREAD_POOL) == 0)        return &threadPool;
+            return nullptr;
+        }
+
+        static bool valueToText (clap_id id, double value, char* text, uint32_t capacity)
+        {
+            value = clampValue (id, value);
+
+            switch (id)
+            {
+                case rateId:    std::snprintf (text, capacity, "%.2f Hz", value); break;
+                case voicesId:  std::snprintf (text, capacity, "%d", static_cast<int> (value)); break;
+                case qualityId: std::snprintf (text, capacity, "%s", qualityNames[static_cast<int> (value)]); break;
+                default:        std::snprintf (text, capacity, "%.0f%%", value * 100.0); break;
+            }
+
+            return true;
+        }
+
+        static bool textToValue (clap_id id, const char* text, double& value)
+        {
+            if (id == qualityId)
+            {
+                for (int i = 0; i < 3; ++i)
+                {
+                    if (std::strcmp (text, qualityNames[i]) == 0)
+                    {
+                        value = i;
+                        return true;
+                    }
+                }
+            }
+
+            char* end = nullptr;
+            const double parsed = std::strtod (text, &end);
+            if (end == text || ! std::isfinite (parsed))
+                return false;
+
+            // Depth y mix se muestran en %
+            value = clampValue (id, (id == depthId || id == mixId) ? parsed / 100.0 : parsed);
+            return true;
+        }
+
+        bool saveState (const clap_ostream_t& stream) const
+        {
+            ChorusState state;
+            state.parameters = getParameters();
+            state.clipOversampling = clipOversampling;
+
+            std::uint8_t bytes[ChorusState::maxSize];
+            const auto size = state.write (bytes, sizeof (bytes));
+
+            // El host puede aceptar menos bytes de los pedidos en cada write
+            for (std::size_t written = 0; written < size;)
+            {
+                const auto result = stream.write (&stream, bytes + written, size - written);
+                if (result <= 0)
+                    return false;
+
+                written += static_cast<std::size_t> (result);
+            }
+
+            return size > 0;
+        }
+
+        bool loadState (const clap_istream_t& stream)
+        {
+            // Cabe de sobra un estado de una version posterior con campos nuevos
+            std::uint8_t bytes[1024];
+            std::size_t size = 0;
+
+            while (size < sizeof (bytes))
+            {
+                const auto result = stream.read (&stream, bytes + size, sizeof (bytes) - size);
+                if (result < 0)
+                    return false;
+                if (result == 0)
+                    break;
+
+                size += static_cast<std::size_t> (result);
+            }
+
+            // Se parte de los valores actuales y solo cambian los campos presentes
+            ChorusState state;
+            state.parameters = getParameters();
+            state.clipOversampling = clipOversampling;
+
+            if (! state.read (bytes, size))
+                return false;
+
+            // Cambia la latencia: los motores se preparan con el modo nuevo en el
+            // siguiente activate, y si estan activos se pide al host que reinicie
+            if (state.clipOversampling != clipOversampling)
+            {
+                clipOversampling = state.clipOversampling;
+                latencyChanged = true;
+
+                if (numSlices > 0)
+                    host->request_restart (host);
+            }
+
+            values[rateId].store (clampValue (rateId, state.parameters.rate), std::memory_order_relaxed);
+            values[depthId].store (clampValue (depthId, state.parameters.depth), std::memory_order_relaxed);
+            values[mixId].store (clampValue (mixId, state.parameters.mix), std::memory_order_relaxed);
+            values[voicesId].store (clampValue (voicesId, state.parameters.voices), std::memory_order_relaxed);
+
+            // El allpass no es una calidad del plugin: si llega en un estado se deja la actual
+            switch (state.parameters.interpolation)
+            {
+                case ChorusEngine::Interpolation::linear:     values[qualityId].store (0.0, std::memory_order_relaxed); break;
+                case ChorusEngine::Interpolation::catmullRom: values[qualityId].store (1.0, std::memory_order_relaxed); break;
+                case ChorusEngine::Interpolation::lagrange:   values[qualityId].store (2.0, std::memory_order_relaxed); break;
+                case ChorusEngine::Interpolation::allpass:    break;
+            }
+
+            // La fase se aplica en el hilo de audio al inicio del siguiente bloque
+            if (state.hasLfoPhase)
+            {
+                pendingLfoPhase.store (state.lfoPhase, std::memory_order_relaxed);
+                hasPendingLfoPhase.store (true, std::memory_order_release);
+            }
+
+            parametersChanged.store (true, std::memory_order_release);
+
+            if (hostParams != nullptr)
+                hostParams->rescan (host, CLAP_PARAM_RESCAN_VALUES);
+
+            return true;
+        }
+
+        // Tramo en curso, leido por los hilos del pool durante request_exec
+        struct Job
+        {
+            float** data32 = nullptr;
+            double** data64 = nullptr;
+            int numChannels = 0;
+            uint32_t offset = 0;
+            uint32_t numFrames = 0;
+        };
+
+        static constexpr double tailSeconds = 0.035;
+
+        clap_plugin_t plugin {};
+        const clap_host_t* host;
+        const clap_host_params_t* hostParams = nullptr;
+        const clap_host_thread_pool_t* hostThreadPool = nullptr;
+        const clap_host_latency_t* hostLatency = nullptr;
+
+        // Valores de los parametros (fuente para get_value, el estado y los motores);
+        // los escriben los eventos en el hilo de audio o flush/load en el principal
+        std::atomic<double> values[numParams];
+        std::atomic<bool> parametersChanged { false };
+        std::atomic<double> pendingLfoPhase { 0.0 };
+        std::atomic<bool> hasPendingLfoPhase { false };
+
+        // Rodilla a 2x (por defecto no: sin latencia); solo en el hilo principal (estado y activate)
+        bool clipOversampling = false;
+        bool latencyChanged = false;
+
+        uint32_t portConfig = 0;
+        int numChannels = 2;
+        int numSlices = 0;
+        int channelsPerSlice = sliceChannels;
+        double currentSampleRate = 44100.0;
+
+        ChorusEngine engines[maxSlices];
+        Job job;
+
+        // Trazas: activate y process nunca van a la vez y comparten anillo
+        TraceRing* traceRing = nullptr;
+        TraceRing* sliceTraceRings[maxSlices] = {};
+    };
+
+    // FACTORIA Y ENTRADA
+    const clap_plugin_factory_t factory =
+    {
+        [] (const clap_plugin_factory_t*) -> uint32_t { return 1; },
+        [] (const clap_plugin_factory_t*, uint32_t index) { return index == 0 ? &descriptor : nullptr; },
+        [] (const clap_plugin_factory_t*, const clap_host_t* host, const char* pluginId) -> const clap_plugin_t*
+        {
+            if (! clap_version_is_compatible (host->clap_version) || std::strcmp (pluginId, descriptor.id) != 0)
+                return nullptr;
+
+            auto* instance = new (std::nothrow) KoruzClap (host);
+            return instance != nullptr ? instance->getPlugin() : nullptr;
+        }
+    };
+}
+
+extern "C" CLAP_EXPORT const clap_plugin_entry_t clap_entry =
+{
+    CLAP_VERSION_INIT,
+    [] (const char*) { return true; },
+    [] () {},
+    [] (const char* factoryId) -> const void* { return std::strcmp (factoryId, CLAP_PLUGIN_FACTORY_ID) == 0 ? &factory : nullptr; }
+};
@@ -0,0 +1,619 @@
+#include <clap/clap.h>
+#include <dlfcn.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#ifndef KORUZ_CLAP_PATH
+ #define KORUZ_CLAP_PATH "Koruz.clap"
+#endif
+
+// Host CLAP minimo y sin interfaz para comprobar Koruz.clap en Linux.
+//
+//   KoruzClapHost [ruta/Koruz.clap]
+//
+// - timing: un cambio de mix en un sample cualquiera del bloque tiene que
+//   aparecer en la salida justo en ese sample mas la latencia, en 32 y 64 bits
+// - thread-pool: 7.1.4 con automatizacion densa da la misma salida, bit a bit,
+//   repartiendo los tramos entre hilos del host que en serie
+// - reposo por grupo: con thread-pool, un grupo de canales que calla, pasa a
+//   reposo y vuelve tiene que seguir en fase con los demas (misma salida, bit a
+//   bit, que sin el silencio una vez pasada la cola)
+// - estado: guardar y cargar en otra instancia conserva los parametros
+//
+// Devuelve != 0 si algo falla.
+namespace
+{
+    enum ParamId : clap_id { rateId, depthId, mixId, voicesId, qualityId };
+
+    constexpr double sampleRate = 48000.0;
+    constexpr uint32_t maxBlockSize = 1024;
+
+    // Pool de hilos del host: request_exec reparte las tareas y vuelve cuando
+    // estan todas hechas; el hilo que llama tambien trabaja
+    class WorkerPool
+    {
+    public:
+        explicit WorkerPool (int numWorkers)
+        {
+            for (int i = 0; i < numWorkers; ++i)
+                workers.emplace_back ([this] { run(); });
+        }
+
+        ~WorkerPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock (mutex);
+                quit = true;
+            }
+
+            wake.notify_all();
+            for (auto& worker : workers)
+                worker.join();
+        }
+
+        void execute (uint32_t numTasks, std::function<void (uint32_t)> newTask)
+        {
+            {
+                std::lock_guard<std::mutex> lock (mutex);
+                task = std::move (newTask);
+                totalTasks = numTasks;
+                nextTask.store (0);
+                doneTasks.store (0);
+                ++generation;
+            }
+
+            wake.notify_all();
+            runTasks();
+
+            std::unique_lock<std::mutex> lock (mutex);
+            done.wait (lock, [this] { return doneTasks.load() == totalTasks; });
+        }
+
+        int getTasksOnWorkers() const { return tasksOnWorkers.load(); }
+
+    private:
+        void run()
+        {
+            unsigned long long seen = 0;
+            for (;;)
+            {
+                {
+                    std::unique_lock<std::mutex> lock (mutex);
+                    wake.wait (lock, [&] { return quit || generation != seen; });
+                    if (quit)
+                        return;
+
+                    seen = generation;
+                }
+
+                tasksOnWorkers += runTasks();
+            }
+        }
+
+        int runTasks()
+        {
+            int count = 0;
+            for (uint32_t index = nextTask++; index < totalTasks; index = nextTask++)
+            {
+                task (index);
+                ++count;
+
+                if (++doneTasks == totalTasks)
+                {
+                    std::lock_guard<std::mutex> lock (mutex);
+                    done.notify_all();
+                }
+            }
+
+            return count;
+        }
+
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable wake, done;
+        std::function<void (uint32_t)> task;
+        std::atomic<uint32_t> totalTasks { 0 };
+        std::atomic<uint32_t> nextTask { 0 };
+        std::atomic<uint32_t> doneTasks { 0 };
+        std::atomic<int> tasksOnWorkers { 0 };
+        unsigned long long generation = 0;
+        bool quit = false;
+    };
+
+    struct EventList
+    {
+        std::vector<clap_event_param_value_t> events;
+
+        void add (uint32_t time, clap_id paramId, double value)
+        {
+            clap_event_param_value_t event {};
+            event.header.size = sizeof (event);
+            event.header.time = time;
+            event.header.space_id = CLAP_CORE_EVENT_SPACE_ID;
+            event.header.type = CLAP_EVENT_PARAM_VALUE;
+            event.param_id = paramId;
+            event.note_id = -1;
+            event.port_index = -1;
+            event.channel = -1;
+            event.key = -1;
+            event.value = value;
+            events.push_back (event);
+        }
+
+        clap_input_events_t getInput() const
+        {
+            return { const_cast<EventList*> (this),
+                     [] (const clap_input_events_t* list) { return static_cast<uint32_t> (static_cast<const EventList*> (list->ctx)->events.size()); },
+                     [] (const clap_input_events_t* list, uint32_t index)
+                     {
+                         return &static_cast<const EventList*> (list->ctx)->events[index].header;
+                     } };
+        }
+    };
+
+    class TestHost
+    {
+    public:
+        TestHost (const clap_plugin_entry_t& pluginEntry, WorkerPool* workerPool)
+            : entry (pluginEntry), pool (workerPool)
+        {
+            host.clap_version = CLAP_VERSION_INIT;
+            host.host_data = this;
+            host.name = "KoruzClapHost";
+            host.vendor = "DavidSignals";
+            host.url = "";
+            host.version = "1.0.0";
+            host.get_extension = [] (const clap_host_t* h, const char* id) -> const void*
+            {
+                static const clap_host_thread_pool_t threadPool =
+                {
+                    [] (const clap_host_t* h, uint32_t numTasks)
+                    {
+                        auto& self = *static_cast<TestHost*> (h->host_data);
+                        self.pool->execute (numTasks, [&self] (uint32_t task) { self.threadPoolExt->exec (self.plugin, task); });
+                        return true;
+                    }
+                };
+
+                const auto& self = *static_cast<const TestHost*> (h->host_data);
+                if (self.pool != nullptr && std::strcmp (id, CLAP_EXT_THREAD_POOL) == 0)
+                    return &threadPool;
+
+                return nullptr;
+            };
+            host.request_restart = [] (const clap_host_t*) {};
+            host.request_process = [] (const clap_host_t*) {};
+            host.request_callback = [] (const clap_host_t*) {};
+
+            const auto* factory = static_cast<const clap_plugin_factory_t*> (entry.get_factory (CLAP_PLUGIN_FACTORY_ID));
+            if (factory == nullptr || factory->get_plugin_count (factory) == 0)
+                return;
+
+            plugin = factory->create_plugin (factory, &host, factory->get_plugin_descriptor (factory, 0)->id);
+            if (plugin == nullptr || ! plugin->init (plugin))
+                return;
+
+            params = static_cast<const clap_plugin_params_t*> (plugin->get_extension (plugin, CLAP_EXT_PARAMS));
+            portsConfig = static_cast<const clap_plugin_audio_ports_config_t*> (plugin->get_extension (plugin, CLAP_EXT_AUDIO_PORTS_CONFIG));
+            latency = static_cast<const clap_plugin_latency_t*> (plugin->get_extension (plugin, CLAP_EXT_LATENCY));
+            state = static_cast<const clap_plugin_state_t*> (plugin->get_extension (plugin, CLAP_EXT_STATE));
+            threadPoolExt = static_cast<const clap_plugin_thread_pool_t*> (plugin->get_extension (plugin, CLAP_EXT_THREAD_POOL));
+        }
+
+        ~TestHost()
+        {
+            if (plugin == nullptr)
+                return;
+
+            if (active)
+            {
+                plugin->stop_processing (plugin);
+                plugin->deactivate (plugin);
+            }
+
+            plugin->destroy (plugin);
+        }
+
+        bool isValid() const
+        {
+            return plugin != nullptr && params != nullptr && portsConfig != nullptr && latency != nullptr
+                && state != nullptr && threadPoolExt != nullptr;
+        }
+
+        // Con el plugin desactivado: configuracion de puertos y parametros sin rampa
+        bool setUp (uint32_t numChannels, const EventList& initial)
+        {
+            for (uint32_t i = 0; i < portsConfig->count (plugin); ++i)
+            {
+                clap_audio_ports_config_t config {};
+                if (portsConfig->get (plugin, i, &config) && config.main_output_channel_count == numChannels)
+                    portsConfig->select (plugin, config.id);
+            }
+
+            channels = numChannels;
+            const auto in = initial.getInput();
+            const clap_output_events_t out { nullptr, [] (const clap_output_events_t*, const clap_event_header_t*) { return false; } };
+            params->flush (plugin, &in, &out);
+
+            active = plugin->activate (plugin, sampleRate, 1, maxBlockSize) && plugin->start_processing (plugin);
+            return active;
+        }
+
+        template <typename SampleType>
+        void process (SampleType* const* data, uint32_t numFrames, const EventList& events)
+        {
+            std::vector<SampleType*> pointers (data, data + channels);
+
+            clap_audio_buffer_t input {}, output {};
+            input.channel_count = output.channel_count = channels;
+            setData (input, pointers.data());
+            setData (output, pointers.data());
+
+            const auto in = events.getInput();
+            const clap_output_events_t out { nullptr, [] (const clap_output_events_t*, const clap_event_header_t*) { return false; } };
+
+            clap_process_t process {};
+            process.steady_time = steadyTime;
+            process.frames_count = numFrames;
+            process.audio_inputs = &input;
+            process.audio_outputs = &output;
+            process.audio_inputs_count = 1;
+            process.audio_outputs_count = 1;
+            process.in_events = &in;
+            process.out_events = &out;
+            plugin->process (plugin, &process);
+
+            steadyTime += numFrames;
+        }
+
+        uint32_t getLatency() const { return latency->get (plugin); }
+
+        double getValue (clap_id id) const
+        {
+            double value = 0.0;
+            params->get_value (plugin, id, &value);
+            return value;
+        }
+
+        std::vector<std::uint8_t> saveState() const
+        {
+            std::vector<std::uint8_t> bytes;
+            const clap_ostream_t stream { &bytes, [] (const clap_ostream_t* s, const void* buffer, uint64_t size) -> int64_t
+            {
+                // De tres en tres bytes, como un host que acepta escrituras parciales
+                const auto accepted = std::min<uint64_t> (size, 3);
+                auto& dest = *static_cast<std::vector<std::uint8_t>*> (s->ctx);
+                dest.insert (dest.end(), static_cast<const std::uint8_t*> (buffer), static_cast<const std::uint8_t*> (buffer) + accepted);
+                return static_cast<int64_t> (accepted);
+            } };
+
+            if (! state->save (plugin, &stream))
+                bytes.clear();
+
+            return bytes;
+        }
+
+        bool loadState (const std::vector<std::uint8_t>& bytes)
+        {
+            struct Reader { const std::vector<std::uint8_t>* bytes; size_t position; } reader { &bytes, 0 };
+            const clap_istream_t stream { &reader, [] (const clap_istream_t* s, void* buffer, uint64_t size) -> int64_t
+            {
+                auto& r = *static_cast<Reader*> (s->ctx);
+                const auto count = std::min<uint64_t> (size, r.bytes->size() - r.position);
+                std::memcpy (buffer, r.bytes->data() + r.position, count);
+                r.position += count;
+                return static_cast<int64_t> (count);
+            } };
+
+            return state->load (plugin, &stream);
+        }
+
+    private:
+        static void setData (clap_audio_buffer_t& buffer, float** data) { buffer.data32 = data; }
+        static void setData (clap_audio_buffer_t& buffer, double** data) { buffer.data64 = data; }
+
+        const clap_plugin_entry_t& entry;
+        WorkerPool* pool;
+        clap_host_t host {};
+        const clap_plugin_t* plugin = nullptr;
+        const clap_plugin_params_t* params = nullptr;
+        const clap_plugin_audio_ports_config_t* portsConfig = nullptr;
+        const clap_plugin_latency_t* latency = nullptr;
+        const clap_plugin_state_t* state = nullptr;
+        const clap_plugin_thread_pool_t* threadPoolExt = nullptr;
+        uint32_t channels = 2;
+        int64_t steadyTime = 0;
+        bool active = false;
+    };
+
+    int failures = 0;
+
+    void check (bool condition, const char* what)
+    {
+        if (! condition)
+        {
+            std::printf ("FAIL: %s\n", what);
+            ++failures;
+        }
+    }
+
+    // Procesa stereo en bloques de blockSize; devuelve el canal izquierdo
+    template <typename SampleType>
+    std::vector<SampleType> renderTiming (const clap_plugin_entry_t& entry, uint32_t blockSize, int eventFrame, int numFrames)
+    {
+        TestHost host (entry, nullptr);
+        EventList initial;
+        initial.add (0, mixId, 0.0);
+        initial.add (0, depthId, 0.6);
+
+        std::vector<SampleType> left ((size_t) numFrames), right ((size_t) numFrames);
+        for (int i = 0; i < numFrames; ++i)
+            left[(size_t) i] = right[(size_t) i] = static_cast<SampleType> (0.5 * std::sin (2.0 * M_PI * 440.0 * i / sampleRate));
+
+        if (! host.isValid() || ! host.setUp (2, initial))
+            return {};
+
+        for (int start = 0; start < numFrames; start += (int) blockSize)
+        {
+            const auto count = std::min<int> ((int) blockSize, numFrames - start);
+
+            EventList events;
+            if (eventFrame >= start && eventFrame < start + count)
+                events.add (static_cast<uint32_t> (eventFrame - start), mixId, 1.0);
+
+            SampleType* data[] = { left.data() + start, right.data() + start };
+            host.process (data, static_cast<uint32_t> (count), events);
+        }
+
+        return left;
+    }
+
+    template <typename SampleType>
+    void checkEventTiming (const clap_plugin_entry_t& entry, uint32_t latency, const char* label)
+    {
+        // El evento va despues de 4096 frames, con el delay line ya lleno
+        for (const uint32_t blockSize : { 1u, 64u, 100u, 512u, 1024u })
+        {
+            std::vector<uint32_t> offsets { 0u, 1u, 7u, blockSize / 2, blockSize - 1 };
+            offsets.erase (std::remove_if (offsets.begin(), offsets.end(), [blockSize] (uint32_t o) { return o >= blockSize; }), offsets.end());
+            std::sort (offsets.begin(), offsets.end());
+            offsets.erase (std::unique (offsets.begin(), offsets.end()), offsets.end());
+
+            for (const uint32_t offset : offsets)
+            {
+                const int eventFrame = static_cast<int> (((4096 + blockSize - 1) / blockSize) * blockSize + offset);
+                const int numFrames = eventFrame + static_cast<int> (latency) + 256;
+
+                const auto dry = renderTiming<SampleType> (entry, blockSize, -1, numFrames);
+                const auto wet = renderTiming<SampleType> (entry, blockSize, eventFrame, numFrames);
+
+                int firstChange = -1;
+                for (int i = 0; i < numFrames && firstChange < 0 && ! dry.empty() && ! wet.empty(); ++i)
+                    if (dry[(size_t) i] != wet[(size_t) i])
+                        firstChange = i;
+
+                const int error = firstChange - (eventFrame + static_cast<int> (latency));
+                std::printf ("timing %-7s block %4u  offset %4u  event %5d  first change %5d  error %d\n",
+                             label, blockSize, offset, eventFrame, firstChange, error);
+                check (firstChange >= 0 && error == 0, "parameter event lands on its sample");
+            }
+        }
+    }
+
+    std::vector<float> renderSurround (const clap_plugin_entry_t& entry, WorkerPool* pool)
+    {
+        constexpr uint32_t numChannels = 12;
+        constexpr int numFrames = static_cast<int> (sampleRate) * 2;
+
+        TestHost host (entry, pool);
+        if (! host.isValid() || ! host.setUp (numChannels, EventList()))
+            return {};
+
+        std::mt19937 rng (11);
+        std::uniform_real_distribution<float> noise (-0.8f, 0.8f);
+        std::uniform_real_distribution<double> unit (0.0, 1.0);
+
+        std::vector<float> audio ((size_t) numFrames * numChannels);
+        for (auto& sample : audio)
+            sample = noise (rng);
+
+        std::vector<float*> data (numChannels);
+        std::uniform_int_distribution<uint32_t> blockSizes (1, maxBlockSize);
+
+        for (int start = 0; start < numFrames;)
+        {
+            const auto count = std::min<uint32_t> (blockSizes (rng), static_cast<uint32_t> (numFrames - start));
+
+            // Automatizacion densa: un evento cada ~97 samples, algunos en el mismo instante
+            EventList events;
+            for (uint32_t t = (uint32_t) (unit (rng) * 97.0); t < count; t += 1 + (uint32_t) (unit (rng) * 193.0))
+            {
+                events.add (t, depthId, unit (rng));
+                events.add (t, mixId, unit (rng));
+                if (unit (rng) < 0.3)
+                    events.add (t, rateId, 0.1 + 1.9 * unit (rng));
+                if (unit (rng) < 0.05)
+                    events.add (t, voicesId, 1.0 + std::floor (8.0 * unit (rng)));
+            }
+
+            // Planar por canal dentro de un buffer [canal][frame] comun
+            std::vector<std::vector<float>> block (numChannels, std::vector<float> (count));
+            for (uint32_t ch = 0; ch < numChannels; ++ch)
+            {
+                for (uint32_t i = 0; i < count; ++i)
+                    block[ch][i] = audio[(size_t) (start + (int) i) * numChannels + ch];
+
+                data[ch] = block[ch].data();
+            }
+
+            host.process (data.data(), count, events);
+
+            for (uint32_t ch = 0; ch < numChannels; ++ch)
+                for (uint32_t i = 0; i < count; ++i)
+                    audio[(size_t) (start + (int) i) * numChannels + ch] = block[ch][i];
+
+            start += (int) count;
+        }
+
+        return audio;
+    }
+
+    void checkThreadPool (const clap_plugin_entry_t& entry)
+    {
+        WorkerPool pool (3);
+        const auto serial = renderSurround (entry, nullptr);
+        const auto pooled = renderSurround (entry, &pool);
+
+        size_t mismatches = serial.size() == pooled.size() && ! serial.empty() ? 0 : 1;
+        for (size_t i = 0; i < std::min (serial.size(), pooled.size()); ++i)
+            mismatches += serial[i] != pooled[i] ? 1 : 0;
+
+        std::printf ("thread-pool 7.1.4: %d slice tasks on host workers, %zu mismatching samples\n",
+                     pool.getTasksOnWorkers(), mismatches);
+        check (pool.getTasksOnWorkers() > 0, "thread-pool used by the plugin");
+        check (mismatches == 0, "thread-pool output matches serial output");
+    }
+
+    // 7.1.4 con thread-pool (tres motores de cuatro canales); con silentSlice >= 0
+    // ese grupo calla de 0.5 s a 1 s, bastante mas que su cola
+    std::vector<float> renderSliceGap (const clap_plugin_entry_t& entry, WorkerPool& pool, int silentSlice)
+    {
+        constexpr uint32_t numChannels = 12;
+        constexpr int numFrames = static_cast<int> (sampleRate) * 2;
+        constexpr int gapStart = numFrames / 4;
+        constexpr int gapEnd = numFrames / 2;
+
+        EventList initial;
+        initial.add (0, depthId, 1.0);
+        initial.add (0, mixId, 1.0);
+        initial.add (0, rateId, 1.7);
+        initial.add (0, voicesId, 3.0);
+
+        TestHost host (entry, &pool);
+        if (! host.isValid() || ! host.setUp (numChannels, initial))
+            return {};
+
+        std::mt19937 rng (5);
+        std::uniform_real_distribution<float> noise (-0.5f, 0.5f);
+        std::vector<std::vector<float>> audio (numChannels, std::vector<float> ((size_t) numFrames));
+
+        for (uint32_t ch = 0; ch < numChannels; ++ch)
+            for (int i = 0; i < numFrames; ++i)
+            {
+                const float sample = noise (rng);
+                const bool silent = (int) ch / 4 == silentSlice && i >= gapStart && i < gapEnd;
+                audio[ch][(size_t) i] = silent ? 0.0f : sample;
+            }
+
+        std::vector<float*> data (numChannels);
+        for (int start = 0; start < numFrames; start += 512)
+        {
+            for (uint32_t ch = 0; ch < numChannels; ++ch)
+                data[ch] = audio[ch].data() + start;
+
+            host.process (data.data(), std::min<uint32_t> (512, (uint32_t) (numFrames - start)), EventList());
+        }
+
+        // Desde 0.1 s despues del silencio: el delay line ya vuelve a tener la misma senal
+        std::vector<float> tail;
+        for (uint32_t ch = 0; ch < numChannels; ++ch)
+            tail.insert (tail.end(), audio[ch].begin() + gapEnd + static_cast<int> (sampleRate / 10), audio[ch].end());
+
+        return tail;
+    }
+
+    void checkSliceIdle (const clap_plugin_entry_t& entry)
+    {
+        WorkerPool pool (3);
+        const auto continuous = renderSliceGap (entry, pool, -1);
+        const auto resumed = renderSliceGap (entry, pool, 0);
+
+        size_t mismatches = continuous.size() == resumed.size() && ! continuous.empty() ? 0 : 1;
+        for (size_t i = 0; i < std::min (continuous.size(), resumed.size()); ++i)
+            mismatches += continuous[i] != resumed[i] ? 1 : 0;
+
+        std::printf ("slice idle 7.1.4: %zu mismatching samples after one group idled and resumed\n", mismatches);
+        check (mismatches == 0, "idle slice resumes in phase with the others");
+    }
+
+    void checkState (const clap_plugin_entry_t& entry)
+    {
+        EventList settings;
+        settings.add (0, rateId, 1.37);
+        settings.add (0, depthId, 0.81);
+        settings.add (0, mixId, 0.33);
+        settings.add (0, voicesId, 5.0);
+        settings.add (0, qualityId, 2.0);
+
+        TestHost source (entry, nullptr);
+        TestHost restored (entry, nullptr);
+        if (! source.isValid() || ! restored.isValid() || ! source.setUp (2, settings))
+        {
+            check (false, "state hosts");
+            return;
+        }
+
+        const auto bytes = source.saveState();
+        check (! bytes.empty() && restored.loadState (bytes), "state save/load");
+
+        bool same = true;
+        for (const clap_id id : { rateId, depthId, mixId, voicesId, qualityId })
+            same = same && static_cast<float> (source.getValue (id)) == static_cast<float> (restored.getValue (id));
+
+        std::printf ("state: %zu bytes, parameters %s\n", bytes.size(), same ? "restored" : "differ");
+        check (same, "state restores parameters");
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    const char* path = argc > 1 ? argv[1] : KORUZ_CLAP_PATH;
+
+    void* library = dlopen (path, RTLD_NOW | RTLD_LOCAL);
+    if (library == nullptr)
+    {
+        std::fprintf (stderr, "Cannot load %s: %s\n", path, dlerror());
+        return 1;
+    }
+
+    const auto* entry = static_cast<const clap_plugin_entry_t*> (dlsym (library, "clap_entry"));
+    if (entry == nullptr || ! clap_version_is_compatible (entry->clap_version) || ! entry->init (path))
+    {
+        std::fprintf (stderr, "%s is not a CLAP plugin\n", path);
+        return 1;
+    }
+
+    uint32_t latency = 0;
+    {
+        TestHost probe (*entry, nullptr);
+        check (probe.isValid(), "plugin and extensions");
+        if (probe.isValid())
+            latency = probe.getLatency();
+    }
+
+    std::printf ("%s, latency %u samples\n", path, latency);
+
+    if (failures == 0)
+    {
+        checkEventTiming<float> (*entry, latency, "32-bit");
+        checkEventTiming<double> (*entry, latency, "64-bit");
+        checkThreadPool (*entry);
+        checkSliceIdle (*entry);
+        checkState (*entry);
+    }
+
+    entry->deinit();
+    dlclose (library);
+
+    std::printf ("clap host: %s (%d failures)\n", failures == 0 ? "ok" : "FAILED", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,307 @@
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Render offline de Koruz sobre ficheros WAV, sin DAW.
+// Cada fichero pasa por un KoruzAudioProcessor propio en bloques fijos (lectura
+// por trozos, nunca el fichero entero en memoria). La salida es la misma, bit a
+// bit, que da el plugin con los mismos ajustes y cualquier tamano de bloque: el
+// motor no depende de como se trocea el audio. Solo en un tramo por debajo de
+// -120 dBFS (sin ser cero) mas largo que la cola puede apartarse: el reposo se
+// decide por bloque y descarta el wet de ese tramo, menos de -110 dBFS.
+
+namespace
+{
+    struct RenderOptions
+    {
+        ChorusEngine::Parameters parameters;
+        int quality = 1;             // Eco / Normal / HQ
+        int blockSize = 512;
+        int numThreads = 0;          // 0 = uno por nucleo
+        int bitsPerSample = 32;      // 32 = float, identico al plugin
+        bool appendTail = false;
+        juce::String suffix = "_koruz";
+        juce::File outputDirectory;
+        std::vector<juce::File> inputs;
+    };
+
+    // Pool con robo de trabajo: cada hilo saca de su cola por detras y, si se
+    // queda sin trabajo, roba por delante de la cola de otro
+    class WorkStealingPool
+    {
+    public:
+        explicit WorkStealingPool (int numWorkers) : queues (static_cast<size_t> (std::max (numWorkers, 1))) {}
+
+        void add (int worker, int job)
+        {
+            auto& q = queues[(size_t) worker % queues.size()];
+            std::lock_guard<std::mutex> lock (q.mutex);
+            q.jobs.push_back (job);
+        }
+
+        template <typename JobFn>
+        void run (JobFn&& processJob)
+        {
+            std::vector<std::thread> threads;
+            for (size_t w = 0; w < queues.size(); ++w)
+                threads.emplace_back ([this, w, &processJob]
+                {
+                    int job;
+                    while (takeJob (w, job))
+                        processJob (job);
+                });
+
+            for (auto& t : threads)
+                t.join();
+        }
+
+    private:
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<int> jobs;
+        };
+
+        bool takeJob (size_t worker, int& job)
+        {
+            {
+                auto& own = queues[worker];
+                std::lock_guard<std::mutex> lock (own.mutex);
+                if (! own.jobs.empty())
+                {
+                    job = own.jobs.back();
+                    own.jobs.pop_back();
+                    return true;
+                }
+            }
+
+            for (size_t i = 1; i < queues.size(); ++i)
+            {
+                auto& victim = queues[(worker + i) % queues.size()];
+                std::lock_guard<std::mutex> lock (victim.mutex);
+                if (! victim.jobs.empty())
+                {
+                    job = victim.jobs.front();
+                    victim.jobs.pop_front();
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        std::vector<Queue> queues;
+    };
+
+    void setParameter (juce::RangedAudioParameter* param, float value)
+    {
+        param->setValueNotifyingHost (param->convertTo0to1 (value));
+    }
+
+    juce::String renderFile (const juce::File& input, const RenderOptions& options)
+    {
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+
+        std::unique_ptr<juce::AudioFormatReader> reader (formats.createReaderFor (input));
+        if (reader == nullptr)
+            return "cannot read " + input.getFullPathName();
+
+        const int numChannels = static_cast<int> (reader->numChannels);
+        if (numChannels < 1 || numChannels > KoruzAudioProcessor::maxNumChannels)
+            return input.getFileName() + ": only files with 1 to " + juce::String (KoruzAudioProcessor::maxNumChannels) + " channels are supported";
+
+        const auto outputDirectory = options.outputDirectory == juce::File() ? input.getParentDirectory()
+                                                                              : options.outputDirectory;
+        const auto output = outputDirectory.getChildFile (input.getFileNameWithoutExtension() + options.suffix + ".wav");
+        output.deleteFile();
+
+        std::unique_ptr<juce::FileOutputStream> stream (output.createOutputStream());
+        if (stream == nullptr)
+            return "cannot write " + output.getFullPathName();
+
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer (wav.createWriterFor (stream.get(), reader->sampleRate,
+                                                                              static_cast<unsigned int> (numChannels),
+                                                                              options.bitsPerSample, {}, 0));
+        if (writer == nullptr)
+            return "cannot create WAV writer for " + output.getFullPathName();
+
+        stream.release();   // ahora es del writer
+
+        // Mismo camino que en un host: layout, parametros, prepare y processBlock
+        KoruzAudioProcessor processor;
+        // WAV multicanal: layout canonico para ese numero de canales, o canales discretos
+        auto layout = juce::AudioChannelSet::canonicalChannelSet (numChannels);
+        if (layout.isDisabled())
+            layout = juce::AudioChannelSet::discreteChannels (numChannels);
+
+        juce::AudioProcessor::BusesLayout buses;
+        buses.inputBuses.add (layout);
+        buses.outputBuses.add (layout);
+        processor.setBusesLayout (buses);
+
+        setParameter (processor.getRateParam(), options.parameters.rate);
+        setParameter (processor.getDepthParam(), options.parameters.depth);
+        setParameter (processor.getMixParam(), options.parameters.mix);
+        setParameter (processor.getVoicesParam(), static_cast<float> (options.parameters.voices));
+        *processor.getQualityParam() = options.quality;
+
+        processor.setNonRealtime (true);   // sin gobernador de CPU: salida reproducible
+        processor.setRateAndBufferSizeDetails (reader->sampleRate, options.blockSize);
+        processor.prepareToPlay (reader->sampleRate, options.blockSize);
+
+        const auto tailSamples = options.appendTail
+                               ? static_cast<juce::int64> (std::ceil (processor.getTailLengthSeconds() * reader->sampleRate))
+                               : 0;
+        // Como un host con compensacion de latencia: se procesan latency frames de mas
+        // y se descartan los primeros, asi la salida queda alineada con la entrada
+        const int latency = processor.getLatencySamples();
+        const auto totalSamples = reader->lengthInSamples + tailSamples + latency;
+
+        juce::AudioBuffer<float> buffer (numChannels, options.blockSize);
+        juce::MidiBuffer midi;
+
+        for (juce::int64 position = 0; position < totalSamples; position += options.blockSize)
+        {
+            const int numSamples = static_cast<int> (std::min<juce::int64> (options.blockSize, totalSamples - position));
+            buffer.setSize (numChannels, numSamples, false, false, true);
+
+            // Fuera del fichero (cola) el lector rellena con ceros
+            reader->read (&buffer, 0, numSamples, position, true, numChannels > 1);
+            processor.processBlock (buffer, midi);
+
+            const auto skip = static_cast<int> (juce::jlimit<juce::int64> (0, numSamples, latency - position));
+            if (skip < numSamples && ! writer->writeFromAudioSampleBuffer (buffer, skip, numSamples - skip))
+                return "write failed for " + output.getFullPathName();
+        }
+
+        processor.releaseResources();
+        return {};
+    }
+
+    void printUsage()
+    {
+        std::printf ("Usage: KoruzRender [options] <input.wav>...\n"
+                     "  --rate <hz>       LFO rate (default 0.8)\n"
+                     "  --depth <0..1>    depth (default 0.4)\n"
+                     "  --mix <0..1>      dry/wet (default 0.5)\n"
+                     "  --voices <1..8>   taps per channel (default 1)\n"
+                     "  --quality <eco|normal|hq>  interpolation tier (default normal)\n"
+                     "  --block <n>       processing block size (default 512)\n"
+                     "  --threads <n>     worker threads (default: one per core)\n"
+                     "  --bits <16|24|32> output bit depth, 32 = float (default 32)\n"
+                     "  --tail            append the chorus tail after the end of the input\n"
+                     "  --out <dir>       output directory (default: next to each input)\n"
+                     "  --suffix <s>      output name suffix (default _koruz)\n");
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    RenderOptions options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg (argv[i]);
+        const bool hasValue = i + 1 < argc;
+
+        if (arg == "--rate" && hasValue)
+            options.parameters.rate = static_cast<float> (std::atof (argv[++i]));
+        else if (arg == "--depth" && hasValue)
+            options.parameters.depth = static_cast<float> (std::atof (argv[++i]));
+        else if (arg == "--mix" && hasValue)
+            options.parameters.mix = static_cast<float> (std::atof (argv[++i]));
+        else if (arg == "--voices" && hasValue)
+            options.parameters.voices = std::atoi (argv[++i]);
+        else if (arg == "--quality" && hasValue)
+        {
+            const std::string tier (argv[++i]);
+            if (tier != "eco" && tier != "normal" && tier != "hq")
+            {
+                printUsage();
+                return 1;
+            }
+
+            options.quality = tier == "eco" ? 0 : (tier == "hq" ? 2 : 1);
+        }
+        else if (arg == "--block" && hasValue)
+            options.blockSize = std::max (1, std::atoi (argv[++i]));
+        else if (arg == "--threads" && hasValue)
+            options.numThreads = std::max (0, std::atoi (argv[++i]));
+        else if (arg == "--bits" && hasValue)
+            options.bitsPerSample = std::atoi (argv[++i]);
+        else if (arg == "--tail")
+            options.appendTail = true;
+        else if (arg == "--out" && hasValue)
+            options.outputDirectory = juce::File::getCurrentWorkingDirectory().getChildFile (argv[++i]);
+        else if (arg == "--suffix" && hasValue)
+            options.suffix = argv[++i];
+        else if (arg.rfind ("--", 0) != 0)
+            options.inputs.push_back (juce::File::getCurrentWorkingDirectory().getChildFile (argv[i]));
+        else
+        {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    if (options.inputs.empty() || (options.bitsPerSample != 16 && options.bitsPerSample != 24 && options.bitsPerSample != 32))
+    {
+        printUsage();
+        return 1;
+    }
+
+    if (options.outputDirectory != juce::File())
+        options.outputDirectory.createDirectory();
+
+    // Un trabajo por fichero: los canales de un fichero comparten LFO y deteccion
+    // de silencio y ya van juntos en carriles SIMD, separarlos no ahorra nada
+    const int numJobs = static_cast<int> (options.inputs.size());
+    const int hardwareThreads = std::max (1, static_cast<int> (std::thread::hardware_concurrency()));
+    const int numWorkers = std::min (numJobs, options.numThreads > 0 ? options.numThreads : hardwareThreads);
+
+    // Reparto inicial por tamano (mayores primero), el robo equilibra el resto
+    std::vector<int> order (static_cast<size_t> (numJobs));
+    for (int i = 0; i < numJobs; ++i)
+        order[(size_t) i] = i;
+    std::sort (order.begin(), order.end(), [&options] (int a, int b)
+    {
+        return options.inputs[(size_t) a].getSize() > options.inputs[(size_t) b].getSize();
+    });
+
+    WorkStealingPool pool (numWorkers);
+    for (int i = 0; i < numJobs; ++i)
+        pool.add (i % numWorkers, order[(size_t) numJobs - 1 - (size_t) i]);
+
+    std::atomic<int> failures { 0 };
+    std::mutex printMutex;
+
+    pool.run ([&] (int job)
+    {
+        const auto& input = options.inputs[(size_t) job];
+        const auto error = renderFile (input, options);
+
+        std::lock_guard<std::mutex> lock (printMutex);
+        if (error.isEmpty())
+        {
+            std::printf ("rendered %s\n", input.getFileName().toRawUTF8());
+        }
+        else
+        {
+            std::fprintf (stderr, "error: %s\n", error.toRawUTF8());
+            ++failures;
+        }
+        std::fflush (stdout);
+    });
+
+    return failures.load() == 0 ? 0 : 1;
+}
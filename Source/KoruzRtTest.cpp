@@ -0,0 +1,372 @@
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "KoruzTrace.h"
+#include "Interpolators.h"
+#include "OversampledClipper.h"
+#include "SimdVec.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined (__GLIBC__)
+ #include <dlfcn.h>
+ #include <pthread.h>
+#endif
+
+// Prueba de tiempo real de KoruzAudioProcessor::processBlock (registrada en CTest).
+// Ejecutable aparte del benchmark: los hooks de abajo sustituyen malloc, new y
+// pthread_mutex_lock en todo el proceso, y no deben pesar en las medidas.
+// Sale con codigo distinto de cero si algo falla.
+
+//==============================================================================
+// VIGILANCIA DEL HILO DE AUDIO
+// Reservas y locks se cuentan solo mientras el hilo tiene armed a true, es
+// decir, dentro de processBlock. operator new/delete se sustituyen en todas las
+// plataformas; con glibc ademas se interponen malloc/calloc/realloc/free y
+// pthread_mutex_lock, que cubren lo que no pasa por new (JUCE, libc, std::mutex).
+
+namespace rtwatch
+{
+    thread_local bool armed = false;
+    std::atomic<int> allocations { 0 };
+    std::atomic<int> deallocations { 0 };
+    std::atomic<int> locks { 0 };
+
+    inline void noteAllocation()   { if (armed) allocations.fetch_add (1, std::memory_order_relaxed); }
+    inline void noteDeallocation() { if (armed) deallocations.fetch_add (1, std::memory_order_relaxed); }
+    inline void noteLock()         { if (armed) locks.fetch_add (1, std::memory_order_relaxed); }
+}
+
+#if defined (__GLIBC__)
+extern "C"
+{
+    void* __libc_malloc (size_t);
+    void* __libc_calloc (size_t, size_t);
+    void* __libc_realloc (void*, size_t);
+    void __libc_free (void*);
+
+    void* malloc (size_t size) noexcept                 { rtwatch::noteAllocation(); return __libc_malloc (size); }
+    void* calloc (size_t count, size_t size) noexcept   { rtwatch::noteAllocation(); return __libc_calloc (count, size); }
+    void* realloc (void* p, size_t size) noexcept       { rtwatch::noteAllocation(); return __libc_realloc (p, size); }
+    void free (void* p) noexcept                        { if (p != nullptr) rtwatch::noteDeallocation(); __libc_free (p); }
+
+    int pthread_mutex_lock (pthread_mutex_t* mutex) noexcept
+    {
+        using LockFn = int (*) (pthread_mutex_t*);
+        static std::atomic<LockFn> next { nullptr };
+
+        auto lock = next.load (std::memory_order_relaxed);
+        if (lock == nullptr)
+        {
+            lock = reinterpret_cast<LockFn> (dlsym (RTLD_NEXT, "pthread_mutex_lock"));
+            next.store (lock, std::memory_order_relaxed);
+        }
+
+        rtwatch::noteLock();
+        return lock (mutex);
+    }
+}
+
+namespace rtwatch
+{
+    constexpr bool hooksLibc = true;
+    inline void* rawAllocate (std::size_t size) { return __libc_malloc (size); }
+    inline void rawFree (void* p)               { __libc_free (p); }
+}
+#else
+namespace rtwatch
+{
+    constexpr bool hooksLibc = false;
+    inline void* rawAllocate (std::size_t size) { return std::malloc (size); }
+    inline void rawFree (void* p)               { std::free (p); }
+}
+#endif
+
+void* operator new (std::size_t size)
+{
+    rtwatch::noteAllocation();
+    if (void* p = rtwatch::rawAllocate (size > 0 ? size : 1))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new (std::size_t size, std::align_val_t alignment)
+{
+    rtwatch::noteAllocation();
+    void* p = nullptr;
+    if (posix_memalign (&p, std::max (sizeof (void*), static_cast<std::size_t> (alignment)), size > 0 ? size : 1) == 0)
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void operator delete (void* p) noexcept
+{
+    if (p != nullptr)
+    {
+        rtwatch::noteDeallocation();
+        rtwatch::rawFree (p);
+    }
+}
+
+void* operator new[] (std::size_t size)                                   { return operator new (size); }
+void* operator new[] (std::size_t size, std::align_val_t alignment)       { return operator new (size, alignment); }
+void operator delete[] (void* p) noexcept                                 { operator delete (p); }
+void operator delete (void* p, std::size_t) noexcept                      { operator delete (p); }
+void operator delete[] (void* p, std::size_t) noexcept                    { operator delete (p); }
+void operator delete (void* p, std::align_val_t) noexcept                 { operator delete (p); }
+void operator delete[] (void* p, std::align_val_t) noexcept               { operator delete (p); }
+void operator delete (void* p, std::size_t, std::align_val_t) noexcept    { operator delete (p); }
+void operator delete[] (void* p, std::size_t, std::align_val_t) noexcept  { operator delete (p); }
+
+namespace
+{
+    struct RtOptions
+    {
+        bool quick = false;
+        std::string tracePath;
+    };
+
+    // Valor normalizado directo, sin listeners (lo que hace un host al automatizar)
+    void setAutomatedValue (juce::AudioProcessorParameter* param, float normalisedValue)
+    {
+        param->setValue (normalisedValue);
+    }
+
+    // Mayor suma de |coeficientes| de un interpolador (cuanto puede pasarse de la entrada)
+    template <typename Interp>
+    float maxWeightSum()
+    {
+        constexpr int W = Float4::width;
+        alignas (16) float weights[ChorusEngine::maxTaps * W];
+        float worst = 1.0f;
+
+        for (int step = 0; step <= 1000; ++step)
+        {
+            Interp::computeWeights (Float4::broadcast (step / 1000.0f), weights, W);
+
+            float sum = 0.0f;
+            for (int tap = 0; tap < Interp::numTaps; ++tap)
+                sum += std::abs (weights[tap * W]);
+
+            worst = std::max (worst, sum);
+        }
+
+        return worst;
+    }
+
+    // processBlock bajo vigilancia: ninguna reserva, liberacion ni lock en el hilo
+    // de audio y salida finita, sin denormales y dentro del limite del soft clip.
+    // Bloques aleatorios (1, impares, mayores que los anunciados), cambios de sample
+    // rate y de layout (mono a 7.1.4, con el desfase de LFO de cada canal) entre
+    // prepareToPlay, y automatizacion extrema en cada bloque. Cada canal empieza en
+    // un desplazamiento distinto de su buffer, asi que los punteros no van alineados
+    int runRealtimeCheck (const RtOptions& options)
+    {
+        const double sampleRates[] = { 22050.0, 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 };
+        const int maxBlockSizes[] = { 1, 7, 64, 127, 441, 512, 1000, 4096 };
+        const juce::AudioChannelSet layouts[] = {
+            juce::AudioChannelSet::mono(),
+            juce::AudioChannelSet::stereo(),
+            juce::AudioChannelSet::create5point1(),
+            juce::AudioChannelSet::create7point1point4()
+        };
+
+        const int numRounds = options.quick ? 16 : 64;
+        const int maxBufferSize = 2 * 4096;
+        const int maxChannelOffset = 7;
+        const int maxChannels = KoruzAudioProcessor::maxNumChannels;
+
+        // Entrada de pico 1: dry + wet (con el sobreimpulso del interpolador de HQ) y despues
+        // la rodilla a 2x del plugin, acotada por la ganancia de sus filtros
+        const float inputPeak = 1.0f;
+        const float preClipPeak = inputPeak * std::max (1.0f, 0.95f * 0.999f * maxWeightSum<LagrangeInterpolator>());
+        const float outputBound = OversampledClipper::getOutputBound (preClipPeak);
+
+        std::mt19937 rng (options.quick ? 7 : 1234);
+        auto uniform = [&rng] (float low, float high) { return std::uniform_real_distribution<float> (low, high) (rng); };
+        auto pick = [&rng] (int count) { return std::uniform_int_distribution<int> (0, count - 1) (rng); };
+
+        KoruzAudioProcessor processor;
+        juce::AudioBuffer<float> floatStorage (maxChannels, maxBufferSize + maxChannelOffset);
+        juce::AudioBuffer<double> doubleStorage (maxChannels, maxBufferSize + maxChannelOffset);
+        std::vector<float*> floatChannels ((size_t) maxChannels);
+        std::vector<double*> doubleChannels ((size_t) maxChannels);
+        juce::MidiBuffer midi;
+
+        long long blocks = 0;
+        long long frames = 0;
+        int nonFinite = 0;
+        int denormals = 0;
+        int overBound = 0;
+        float peak = 0.0f;
+        int surroundRounds = 0;
+
+        for (int round = 0; round < numRounds; ++round)
+        {
+            const double sampleRate = sampleRates[pick (static_cast<int> (std::size (sampleRates)))];
+            const int maxBlockSize = maxBlockSizes[pick (static_cast<int> (std::size (maxBlockSizes)))];
+            const auto& layout = layouts[round % static_cast<int> (std::size (layouts))];   // todos, por turno
+            const int numChannels = layout.size();
+
+            // Fuera de la zona vigilada: layout y prepare pueden reservar
+            juce::AudioProcessor::BusesLayout buses;
+            buses.inputBuses.add (layout);
+            buses.outputBuses.add (layout);
+            processor.setBusesLayout (buses);
+            processor.setRateAndBufferSizeDetails (sampleRate, maxBlockSize);
+            processor.prepareToPlay (sampleRate, maxBlockSize);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                const int offset = pick (maxChannelOffset + 1);
+                floatChannels[(size_t) ch] = floatStorage.getWritePointer (ch) + offset;
+                doubleChannels[(size_t) ch] = doubleStorage.getWritePointer (ch) + offset;
+            }
+
+            surroundRounds += numChannels > 2 ? 1 : 0;
+
+            const auto roundFrames = static_cast<long long> (sampleRate * (options.quick ? 0.25 : 1.0));
+
+            for (long long position = 0; position < roundFrames;)
+            {
+                // Bloque: casi siempre hasta el maximo anunciado, a veces 1 o mas grande
+                const int choice = pick (10);
+                const int numSamples = choice == 0 ? 1
+                                     : choice == 1 ? std::min (maxBufferSize, maxBlockSize * 2 + 1)
+                                     : 1 + pick (maxBlockSize);
+
+                // Automatizacion extrema: saltos de extremo a extremo, como haria un host, sin notificar
+                setAutomatedValue (processor.getRateParam(), static_cast<float> (pick (2)));
+                setAutomatedValue (processor.getDepthParam(), static_cast<float> (pick (2)));
+                setAutomatedValue (processor.getMixParam(), pick (3) * 0.5f);
+                setAutomatedValue (processor.getVoicesParam(), static_cast<float> (pick (2)));
+                setAutomatedValue (processor.getQualityParam(), pick (3) * 0.5f);
+
+                // Senal: ruido a fondo de escala, silencio (reposo), niveles minusculos o DC
+                const int signal = pick (4);
+                const float level = signal == 2 ? 1.0e-30f : inputPeak;
+                const bool useDouble = pick (4) == 0;
+
+                for (int ch = 0; ch < numChannels; ++ch)
+                    for (int i = 0; i < numSamples; ++i)
+                    {
+                        const float x = signal == 1 ? 0.0f : (signal == 3 ? level : uniform (-level, level));
+                        floatChannels[(size_t) ch][i] = x;
+                        doubleChannels[(size_t) ch][i] = x;
+                    }
+
+                if (useDouble)
+                {
+                    juce::AudioBuffer<double> block (doubleChannels.data(), numChannels, numSamples);
+                    rtwatch::armed = true;
+                    processor.processBlock (block, midi);
+                    rtwatch::armed = false;
+
+                    for (int ch = 0; ch < numChannels; ++ch)
+                        for (int i = 0; i < numSamples; ++i)
+                            floatChannels[(size_t) ch][i] = static_cast<float> (doubleChannels[(size_t) ch][i]);
+                }
+                else
+                {
+                    juce::AudioBuffer<float> block (floatChannels.data(), numChannels, numSamples);
+                    rtwatch::armed = true;
+                    processor.processBlock (block, midi);
+                    rtwatch::armed = false;
+                }
+
+                for (int ch = 0; ch < numChannels; ++ch)
+                    for (int i = 0; i < numSamples; ++i)
+                    {
+                        const float y = floatChannels[(size_t) ch][i];
+
+                        if (! std::isfinite (y))
+                            ++nonFinite;
+                        else if (std::fpclassify (y) == FP_SUBNORMAL)
+                            ++denormals;
+                        else if (std::abs (y) > outputBound)
+                            ++overBound;
+
+                        peak = std::max (peak, std::abs (y));
+                    }
+
+                position += numSamples;
+                frames += numSamples;
+                ++blocks;
+            }
+
+            processor.releaseResources();
+        }
+
+        const int allocations = rtwatch::allocations.load();
+        const int deallocations = rtwatch::deallocations.load();
+        const int locks = rtwatch::locks.load();
+        const bool passed = allocations == 0 && deallocations == 0 && locks == 0
+                         && nonFinite == 0 && denormals == 0 && overBound == 0;
+
+        std::printf ("realtime: %lld blocks, %lld frames, %d prepares (%d surround)%s\n", blocks, frames, numRounds, surroundRounds,
+                     rtwatch::hooksLibc ? "" : " (operator new/delete only: malloc and lock hooks need glibc)");
+        std::printf ("  allocations %d, frees %d, mutex locks %d\n", allocations, deallocations, locks);
+        std::printf ("  non-finite %d, denormal %d, over bound %d (peak %.4f, bound %.4f)\n",
+                     nonFinite, denormals, overBound, peak, outputBound);
+        std::printf ("realtime: %s\n", passed ? "ok" : "FAILED");
+        return passed ? 0 : 1;
+    }
+
+    void printUsage()
+    {
+        std::printf ("Usage: KoruzRtTest [--quick] [--trace <file>]\n"
+                     "  --quick      16 short rounds instead of 64 one-second rounds\n"
+                     "  --trace      write the run's processBlock/prepareToPlay trace as Chrome trace JSON (KORUZ_TRACE builds)\n");
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    RtOptions options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg (argv[i]);
+
+        if (arg == "--quick")
+            options.quick = true;
+        else if (arg == "--trace" && i + 1 < argc)
+            options.tracePath = argv[++i];
+        else
+        {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    if (! options.tracePath.empty() && ! KoruzTrace::enabled)
+    {
+        std::fprintf (stderr, "--trace needs a build configured with -DKORUZ_TRACE=ON\n");
+        return 1;
+    }
+
+    const int result = runRealtimeCheck (options);
+
+    // Ultimos eventos de cada hilo (el anillo guarda unos segundos): ui.perfetto.dev o chrome://tracing
+    if (! options.tracePath.empty())
+    {
+        if (! KoruzTrace::writeChromeTrace (options.tracePath.c_str()))
+        {
+            std::fprintf (stderr, "could not write %s\n", options.tracePath.c_str());
+            return 1;
+        }
+
+        std::fprintf (stderr, "trace written to %s\n", options.tracePath.c_str());
+    }
+
+    return result;
+}
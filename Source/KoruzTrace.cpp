@@ -0,0 +1,119 @@
+#include "KoruzTrace.h"
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <vector>
+
+#if KORUZ_TRACE
+
+namespace
+{
+    // Solo se tocan las paginas de los anillos que alguna instancia llega a usar
+    TraceRing rings[KoruzTrace::maxRings];
+
+    struct DumpedEvent
+    {
+        TraceEvent event;
+        int thread = 0;
+    };
+}
+
+std::uint64_t KoruzTrace::now() noexcept
+{
+    return static_cast<std::uint64_t> (std::chrono::duration_cast<std::chrono::nanoseconds> (
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+TraceRing* KoruzTrace::claimRing (const void* owner) noexcept
+{
+    for (auto& ring : rings)
+        if (ring.tryClaim (owner))
+            return &ring;
+
+    return nullptr;
+}
+
+void KoruzTrace::releaseRing (TraceRing* ring) noexcept
+{
+    if (ring != nullptr)
+        ring->release();
+}
+
+void KoruzTrace::record (TraceRing* ring, const char* name, std::uint64_t beginNs, std::uint64_t endNs) noexcept
+{
+    if (ring != nullptr)
+        ring->push (name, beginNs, endNs);
+}
+
+bool KoruzTrace::writeChromeTrace (const char* path)
+{
+    // COPIA - fuera del hilo de audio, aqui si se reserva memoria. Un anillo
+    // liberado conserva sus eventos hasta que otra instancia lo pisa
+    std::vector<TraceEvent> scratch (TraceRing::capacity);
+    std::vector<DumpedEvent> dumped;
+
+    for (int t = 0; t < maxRings; ++t)
+    {
+        const int count = rings[t].snapshot (scratch.data());
+        for (int i = 0; i < count; ++i)
+            dumped.push_back ({ scratch[(size_t) i], t });
+    }
+
+    std::sort (dumped.begin(), dumped.end(),
+               [] (const DumpedEvent& a, const DumpedEvent& b) { return a.event.beginNs < b.event.beginNs; });
+
+    // Instancias numeradas por orden de aparicion; pid 0 es lo que no va dentro de ninguna
+    std::vector<const void*> instances;
+    auto getPid = [&instances] (const void* instance)
+    {
+        if (instance == nullptr)
+            return 0;
+
+        const auto found = std::find (instances.begin(), instances.end(), instance);
+        if (found != instances.end())
+            return static_cast<int> (found - instances.begin()) + 1;
+
+        instances.push_back (instance);
+        return static_cast<int> (instances.size());
+    };
+
+    std::FILE* file = std::fopen (path, "w");
+    if (file == nullptr)
+        return false;
+
+    const std::uint64_t origin = dumped.empty() ? 0 : dumped.front().event.beginNs;
+
+    std::fprintf (file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    std::fprintf (file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"Koruz\"}}");
+
+    for (const auto& d : dumped)
+    {
+        const int numKnown = static_cast<int> (instances.size());
+        const int pid = getPid (d.event.instance);
+
+        if (pid > numKnown)
+            std::fprintf (file, ",\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"Koruz #%d\"}}", pid, pid);
+
+        // Chrome trace cuenta en microsegundos
+        const auto begin = d.event.beginNs - origin;
+        std::fprintf (file, ",\n{\"name\":\"%s\",\"cat\":\"koruz\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+                            "\"ts\":%" PRIu64 ".%03d,\"dur\":%" PRIu64 ".%03d}",
+                      d.event.name, pid, d.thread,
+                      begin / 1000, static_cast<int> (begin % 1000),
+                      d.event.durationNs / 1000, static_cast<int> (d.event.durationNs % 1000));
+    }
+
+    std::fprintf (file, "\n]}\n");
+    return std::fclose (file) == 0;
+}
+
+#else
+
+std::uint64_t KoruzTrace::now() noexcept                        { return 0; }
+TraceRing* KoruzTrace::claimRing (const void*) noexcept         { return nullptr; }
+void KoruzTrace::releaseRing (TraceRing*) noexcept              {}
+void KoruzTrace::record (TraceRing*, const char*, std::uint64_t, std::uint64_t) noexcept {}
+bool KoruzTrace::writeChromeTrace (const char*)                 { return false; }
+
+#endif
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Trazas de los tramos calientes (prepareToPlay, processBlock y las etapas del
+// motor) para ver en un timeline el jitter por bloque y los bloques anomalos.
+//
+// Se activa al compilar con KORUZ_TRACE=1 (opcion KORUZ_TRACE de CMake). Por
+// defecto las macros no generan codigo y no se reserva el pool de anillos.
+//
+// Cada instancia toma sus anillos del pool estatico fuera del hilo de audio
+// (constructor, prepare o activate) y se los pasa a sus motores; cada anillo lo
+// escribe un solo hilo a la vez. Sin thread_local, locks ni memoria dinamica en
+// el hilo de audio. Lleno, el anillo pisa los eventos mas viejos.
+// writeChromeTrace se puede llamar desde cualquier hilo mientras se sigue trazando.
+
+#ifndef KORUZ_TRACE
+ #define KORUZ_TRACE 0
+#endif
+
+struct TraceEvent
+{
+    const char* name = nullptr;         // literal, no se copia
+    const void* instance = nullptr;     // procesador que lo emitio (nullptr fuera de uno)
+    std::uint64_t beginNs = 0;
+    std::uint64_t durationNs = 0;
+};
+
+// Anillo de una instancia: un solo productor, lectores que copian sin pararlo
+class TraceRing
+{
+public:
+    // Unos 8 eventos por bloque: 128 KB son ~5 s a 48 kHz con bloques de 512
+    static constexpr std::uint32_t capacity = 1u << 12;
+
+    void push (const char* name, std::uint64_t beginNs, std::uint64_t endNs) noexcept
+    {
+        const auto w = written.load (std::memory_order_relaxed);
+        auto& event = events[w & (capacity - 1)];
+        event.name = name;
+        event.instance = owner;
+        event.beginNs = beginNs;
+        event.durationNs = endNs - beginNs;
+        written.store (w + 1, std::memory_order_release);
+    }
+
+    bool tryClaim (const void* newOwner) noexcept
+    {
+        if (claimed.exchange (true, std::memory_order_acquire))
+            return false;
+
+        owner = newOwner;
+        return true;
+    }
+
+    void release() noexcept { claimed.store (false, std::memory_order_release); }
+
+    // Copia a out (capacity eventos) los que siguen validos, del mas viejo al
+    // mas nuevo. Los que el productor pisa durante la copia se descartan
+    int snapshot (TraceEvent* out) const noexcept
+    {
+        const auto end = written.load (std::memory_order_acquire);
+        const auto begin = end > capacity ? end - capacity : 0;
+
+        for (auto i = begin; i < end; ++i)
+            out[i - begin] = events[i & (capacity - 1)];
+
+        std::atomic_thread_fence (std::memory_order_acquire);
+        const auto after = written.load (std::memory_order_relaxed);
+        const auto firstValid = after > capacity ? after - capacity : 0;
+        if (firstValid <= begin)
+            return static_cast<int> (end - begin);
+
+        if (firstValid >= end)
+            return 0;
+
+        const auto skipped = firstValid - begin;
+        for (auto i = skipped; i < end - begin; ++i)
+            out[i - skipped] = out[i];
+
+        return static_cast<int> (end - firstValid);
+    }
+
+private:
+    TraceEvent events[capacity];
+    const void* owner = nullptr;
+    alignas (64) std::atomic<std::uint64_t> written { 0 };
+    std::atomic<bool> claimed { false };
+};
+
+class KoruzTrace
+{
+public:
+    static constexpr bool enabled = KORUZ_TRACE != 0;
+    static constexpr int maxRings = 64;
+
+    static std::uint64_t now() noexcept;
+
+    // Fuera del hilo de audio. Devuelve nullptr si esta desactivado o el pool se
+    // agota: las instancias que sobran no trazan
+    static TraceRing* claimRing (const void* owner) noexcept;
+    static void releaseRing (TraceRing* ring) noexcept;
+
+    // Sin anillo no hace nada
+    static void record (TraceRing* ring, const char* name, std::uint64_t beginNs, std::uint64_t endNs) noexcept;
+
+    // JSON de Chrome trace / Perfetto (ui.perfetto.dev, chrome://tracing): un
+    // proceso por instancia y un hilo por anillo. Devuelve false si esta
+    // desactivado o no se puede escribir
+    static bool writeChromeTrace (const char* path);
+};
+
+class TraceScope
+{
+public:
+    TraceScope (TraceRing* traceRing, const char* stageName) noexcept
+        : ring (traceRing), name (stageName), beginNs (KoruzTrace::now()) {}
+
+    ~TraceScope() { KoruzTrace::record (ring, name, beginNs, KoruzTrace::now()); }
+
+    TraceScope (const TraceScope&) = delete;
+    TraceScope& operator= (const TraceScope&) = delete;
+
+private:
+    TraceRing* ring;
+    const char* name;
+    std::uint64_t beginNs;
+};
+
+#define KORUZ_TRACE_JOIN_IMPL(a, b) a##b
+#define KORUZ_TRACE_JOIN(a, b) KORUZ_TRACE_JOIN_IMPL (a, b)
+
+#if KORUZ_TRACE
+ // Mide desde aqui hasta el final del ambito y lo escribe en ring
+ #define KORUZ_TRACE_SCOPE(ring, stageName) const TraceScope KORUZ_TRACE_JOIN (koruzTraceScope, __LINE__) (ring, stageName)
+#else
+ #define KORUZ_TRACE_SCOPE(ring, stageName)
+#endif
@@ -0,0 +1,344 @@
+#pragma once
+
+#include "SimdVec.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+// Rodilla de salida de ChorusEngine (0.99, pendiente 0.3) sobremuestreada a 2x.
+// - La rodilla se separa en lineal + residuo: knee (x) = x + r (x), con r = 0 por
+//   debajo del umbral. Solo el residuo se sobremuestrea (interpolacion a 2x con un
+//   halfband polifasico, r a 2x y diezmado con el mismo filtro); la parte lineal es
+//   la entrada retrasada la latencia de los filtros. Por debajo de la rodilla la
+//   salida es exactamente la entrada retrasada.
+// - Cada canal decide por tramo, en dos pasos. Si el pico de todas las entradas que
+//   alimentan el residuo del tramo (el tramo y los numBranchTaps - 1 frames
+//   anteriores) no llega a engageLevel, la cota del interpolador (umbral / (2 * suma
+//   de |taps|)), el residuo es cero sin calcularlo. Si llega, se sube a 2x y solo se
+//   baja por el diezmador si la rodilla actua en alguna muestra a 2x o queda residuo
+//   de tramos anteriores: el camino completo empieza justo donde empieza la rodilla.
+//   Con residuo cero la salida es la entrada retrasada en cualquier camino, asi que
+//   el resultado no depende de como se trocee la entrada.
+// - Latencia fija en los dos caminos (latencySamples), para reportarla al host.
+// - Las historias por canal no son suyas: las reparte el DspArena del motor. El
+//   tramo de trabajo llega en cada process (memoria de trabajo compartida).
+class OversampledClipper
+{
+public:
+    static constexpr float threshold = 0.99f;
+    static constexpr float kneeSlope = 0.3f;
+    static constexpr float engageLevel = 0.49f;         // 0.99 / 1.998 con margen de redondeo: por debajo no se sube a 2x
+    static constexpr int numTaps = 31;                  // halfband, Kaiser beta 6
+    static constexpr int numBranchTaps = (numTaps + 1) / 2;
+    static constexpr int latencySamples = (numTaps - 1) / 2;   // 7.5 al subir + 7.5 al bajar
+    static constexpr int historyFrames = 16;
+
+    // Floats que necesita prepare: historias de entrada y residuo (par e impar) por canal
+    static size_t getRequiredFloats (int numChannels)
+    {
+        return static_cast<size_t> (3 * historyFrames * numChannels);
+    }
+
+    // Floats del tramo de trabajo para procesar de chunkFrames en chunkFrames: una
+    // copia de cada historia mas el tramo (y 4 de relleno para Float4)
+    static size_t getScratchFloats (int chunkFrames)
+    {
+        return static_cast<size_t> (3 * (historyFrames + chunkFrames + Float4::width));
+    }
+
+    // memory debe tener getRequiredFloats (numChannels) floats y vivir mas que el clipper
+    void prepare (int newNumChannels, float* memory)
+    {
+        numChannels = newNumChannels;
+        storage = memory;
+        storageSize = getRequiredFloats (numChannels);
+        clear();
+    }
+
+    void release()
+    {
+        storage = nullptr;
+        storageSize = 0;
+        numChannels = 0;
+    }
+
+    void clear()
+    {
+        if (storage != nullptr)
+            std::memset (storage, 0, storageSize * sizeof (float));
+
+        std::fill (pending, pending + maxChannels, false);
+    }
+
+    // Sin nada en las historias ni residuo pendiente, un tramo todo a cero sale
+    // igual (ceros) y las deja a cero: process se puede saltar sin cambiar nada
+    template <typename SampleType>
+    bool isPassThrough (SampleType* const* channels, int numChannelsToProcess, int numSamples) const
+    {
+        numChannelsToProcess = std::min (numChannelsToProcess, numChannels);
+
+        for (int ch = 0; ch < numChannelsToProcess; ++ch)
+        {
+            if (pending[ch])
+                return false;
+
+            const float* inputHistory = getHistory (ch, 0);
+            for (int k = 0; k < historyFrames; ++k)
+                if (inputHistory[k] != 0.0f)
+                    return false;
+
+            const SampleType* data = channels[ch];
+            int nonZero = 0;
+            for (int i = 0; i < numSamples; ++i)
+                nonZero += data[i] != 0 ? 1 : 0;
+
+            if (nonZero > 0)
+                return false;
+        }
+
+        return true;
+    }
+
+    // Llamadas a process en las que la rodilla actuo (o se vacio su residuo) en algun canal
+    unsigned long long getEngagedBlocks() const { return engagedBlocks; }
+
+    // Suma de |coeficientes| del ramal par: el interpolador multiplica el pico por
+    // como mucho 2 * getEvenTapsSum()
+    static constexpr float getEvenTapsSum()
+    {
+        float sum = 0.0f;
+        for (float tap : evenTaps)
+            sum += tap < 0.0f ? -tap : tap;
+
+        return sum;
+    }
+
+    // Cota de salida para entradas de pico inputPeak. La parte lineal ya no se
+    // recorta muestra a muestra: el residuo filtrado puede quedarse corto en los
+    // transitorios, asi que la cota sale de la suma de |coeficientes| de cada filtro
+    static float getOutputBound (float inputPeak)
+    {
+        const float evenSum = getEvenTapsSum();
+        const float upsampledPeak = inputPeak * std::max (1.0f, 2.0f * evenSum);
+        const float residualPeak = (1.0f - kneeSlope) * std::max (0.0f, upsampledPeak - threshold);
+        return inputPeak + (evenSum + 0.5f) * residualPeak;
+    }
+
+    // In-place: la salida es la entrada retrasada latencySamples, con la rodilla.
+    // scratch tiene getScratchFloats (chunkFrames) floats; no guarda nada entre llamadas
+    template <typename SampleType>
+    void process (SampleType* const* channels, int numChannelsToProcess, int numSamples, float* scratch, int chunkFrames)
+    {
+        numChannelsToProcess = std::min (numChannelsToProcess, numChannels);
+        scratchBuffer = scratch;
+        scratchFrames = historyFrames + chunkFrames + Float4::width;
+
+        bool engaged = false;
+        for (int offset = 0; offset < numSamples; offset += chunkFrames)
+        {
+            const int n = std::min (chunkFrames, numSamples - offset);
+            for (int ch = 0; ch < numChannelsToProcess; ++ch)
+                engaged = processChannel (channels[ch] + offset, ch, n) || engaged;
+        }
+
+        if (engaged)
+            ++engagedBlocks;
+    }
+
+private:
+    static constexpr int maxChannels = 16;
+
+    // Ramal par del halfband (el impar es solo el centro, 0.5); cada ramal suma 0.5
+    static constexpr float evenTaps[numBranchTaps] =
+    {
+        -0.000315589136f,  0.00176771912f, -0.00520873444f,  0.0119890619f,
+        -0.0242510871f,    0.0465890553f,  -0.0949950130f,   0.314424587f,
+         0.314424587f,    -0.0949950130f,   0.0465890553f,  -0.0242510871f,
+         0.0119890619f,   -0.00520873444f,  0.00176771912f, -0.000315589136f
+    };
+
+    static float getPeak (const float* x, int numSamples)
+    {
+        auto peak = Float4::broadcast (0.0f);
+        int i = 0;
+        for (; i + Float4::width <= numSamples; i += Float4::width)
+        {
+            const auto v = Float4::load (x + i);
+            peak = Float4::max (peak, Float4::max (v, Float4::broadcast (0.0f) - v));
+        }
+
+        alignas (16) float lanes[Float4::width];
+        peak.store (lanes);
+
+        float result = std::max (std::max (lanes[0], lanes[1]), std::max (lanes[2], lanes[3]));
+        for (; i < numSamples; ++i)
+            result = std::max (result, std::abs (x[i]));
+
+        return result;
+    }
+
+    float* getHistory (int channel, int which) const
+    {
+        return storage + static_cast<size_t> ((channel * 3 + which) * historyFrames);
+    }
+
+    float* getScratch (int which) const
+    {
+        return scratchBuffer + static_cast<size_t> (which * scratchFrames);
+    }
+
+    // Devuelve true si el tramo paso por el camino a 2x
+    template <typename SampleType>
+    bool processChannel (SampleType* data, int channel, int numSamples)
+    {
+        constexpr int H = historyFrames;
+        float* input = getScratch (0);
+        float* residualEven = getScratch (1);
+        float* residualOdd = getScratch (2);
+        float* inputHistory = getHistory (channel, 0);
+
+        // ENTRADA - historia + tramo, y pico de todo lo que lee el interpolador
+        std::memcpy (input, inputHistory, H * sizeof (float));
+
+        for (int i = 0; i < numSamples; ++i)
+            input[H + i] = static_cast<float> (data[i]);
+
+        constexpr int interpolatorHistory = numBranchTaps - 1;
+        const float peak = getPeak (input + H - interpolatorHistory, numSamples + interpolatorHistory);
+
+        // SUBIDA A 2x - solo si la rodilla puede llegar a actuar; sin residuo en el
+        // tramo ni pendiente, la bajada sumaria cero
+        bool engaged = pending[channel];
+        if (peak >= engageLevel || engaged)
+            engaged = upsampleResidual (channel, input, residualEven, residualOdd, numSamples) || engaged;
+
+        // CAMINO LINEAL - residuo cero en todo el tramo y nada pendiente: solo retraso
+        if (! engaged)
+        {
+            for (int i = 0; i < numSamples; ++i)
+                data[i] = static_cast<SampleType> (input[H + i - latencySamples]);
+        }
+        else
+        {
+            downsampleResidual (data, channel, input, residualEven, residualOdd, numSamples);
+        }
+
+        std::memcpy (inputHistory, input + numSamples, H * sizeof (float));
+        return engaged;
+    }
+
+    static constexpr int oddDelay = (latencySamples - 1) / 2;   // centro del interpolador, a base rate
+    static constexpr int numPairs = numBranchTaps / 2;          // filtro simetrico: un coeficiente por par de taps
+    static_assert (numPairs % 2 == 0, "two accumulators");
+
+    // Residuo de la rodilla a 2x detras de las historias; devuelve true si no es cero
+    // en alguna muestra del tramo
+    bool upsampleResidual (int channel, const float* input, float* residualEven, float* residualOdd, int numSamples) const
+    {
+        constexpr int H = historyFrames;
+        std::memcpy (residualEven, getHistory (channel, 1), H * sizeof (float));
+        std::memcpy (residualOdd, getHistory (channel, 2), H * sizeof (float));
+
+        const auto t = Float4::broadcast (threshold);
+        const auto negT = Float4::broadcast (-threshold);
+        const auto slope = Float4::broadcast (kneeSlope - 1.0f);
+        const auto zero = Float4::broadcast (0.0f);
+        const auto two = Float4::broadcast (2.0f);
+
+        auto residual = [&] (Float4 u)
+        {
+            return Float4::select (Float4::greaterThan (u, t), (u - t) * slope,
+                   Float4::select (Float4::lessThan (u, negT), (u - negT) * slope, zero));
+        };
+
+        Float4 taps[numPairs];
+        for (int k = 0; k < numPairs; ++k)
+            taps[k] = Float4::broadcast (evenTaps[k]);
+
+        // Cuatro frames por vuelta; los del relleno no se usan ni cuentan
+        auto activity = zero;
+        int i = 0;
+        for (; i < numSamples; i += Float4::width)
+        {
+            const float* x = input + H + i;
+            auto even = zero, evenB = zero;   // dos cadenas de sumas en paralelo
+            for (int k = 0; k < numPairs; k += 2)
+            {
+                even = even + taps[k] * (Float4::load (x - k) + Float4::load (x - (numBranchTaps - 1 - k)));
+                evenB = evenB + taps[k + 1] * (Float4::load (x - k - 1) + Float4::load (x - (numBranchTaps - 2 - k)));
+            }
+
+            const auto r0 = residual (two * (even + evenB));
+            const auto r1 = residual (Float4::load (x - oddDelay));
+            r0.store (residualEven + H + i);
+            r1.store (residualOdd + H + i);
+
+            if (i + Float4::width <= numSamples)
+                activity = Float4::max (activity, Float4::max (Float4::max (r0, zero - r0), Float4::max (r1, zero - r1)));
+        }
+
+        alignas (16) float lanes[Float4::width];
+        activity.store (lanes);
+
+        bool active = std::max (std::max (lanes[0], lanes[1]), std::max (lanes[2], lanes[3])) > 0.0f;
+        for (int j = numSamples - numSamples % Float4::width; j < numSamples; ++j)
+            active = active || residualEven[H + j] != 0.0f || residualOdd[H + j] != 0.0f;
+
+        return active;
+    }
+
+    // Lineal retrasado + residuo filtrado de vuelta a 1x; guarda las historias del residuo
+    template <typename SampleType>
+    void downsampleResidual (SampleType* data, int channel, const float* input, const float* residualEven, const float* residualOdd, int numSamples)
+    {
+        constexpr int H = historyFrames;
+        const auto zero = Float4::broadcast (0.0f);
+        const auto half = Float4::broadcast (0.5f);
+
+        Float4 taps[numPairs];
+        for (int k = 0; k < numPairs; ++k)
+            taps[k] = Float4::broadcast (evenTaps[k]);
+
+        alignas (16) float out[Float4::width];
+        for (int i = 0; i < numSamples; i += Float4::width)
+        {
+            const float* r = residualEven + H + i;
+            auto sum = half * Float4::load (residualOdd + H + i - oddDelay - 1), sumB = zero;
+            for (int k = 0; k < numPairs; k += 2)
+            {
+                sum = sum + taps[k] * (Float4::load (r - k) + Float4::load (r - (numBranchTaps - 1 - k)));
+                sumB = sumB + taps[k + 1] * (Float4::load (r - k - 1) + Float4::load (r - (numBranchTaps - 2 - k)));
+            }
+
+            (Float4::load (input + H + i - latencySamples) + (sum + sumB)).store (out);
+
+            const int count = std::min (Float4::width, numSamples - i);
+            for (int lane = 0; lane < count; ++lane)
+                data[i + lane] = static_cast<SampleType> (out[lane]);
+        }
+
+        float* evenHistory = getHistory (channel, 1);
+        float* oddHistory = getHistory (channel, 2);
+        std::memcpy (evenHistory, residualEven + numSamples, H * sizeof (float));
+        std::memcpy (oddHistory, residualOdd + numSamples, H * sizeof (float));
+
+        // Mientras quede residuo en la historia el siguiente bloque sigue por aqui
+        bool active = false;
+        for (int k = 0; k < H; ++k)
+            active = active || evenHistory[k] != 0.0f || oddHistory[k] != 0.0f;
+
+        pending[channel] = active;
+    }
+
+    float* storage = nullptr;
+    size_t storageSize = 0;
+    float* scratchBuffer = nullptr;
+    int scratchFrames = 0;
+    int numChannels = 0;
+    bool pending[maxChannels] = {};
+    unsigned long long engagedBlocks = 0;
+};
+
+static_assert (2.0f * OversampledClipper::getEvenTapsSum() * OversampledClipper::engageLevel < OversampledClipper::threshold,
+               "engageLevel must stay under the interpolator bound");
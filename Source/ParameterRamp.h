@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cmath>
+
+// Rampa de parametro para ChorusEngine. Mientras el valor no cambia no se
+// genera nada y el motor usa constantes de bloque; solo cuando hay un nuevo
+// objetivo se rellena un buffer por frame durante rampLength samples.
+// Lineal para ganancias (mix, depth), exponencial para frecuencias (rate).
+// Cada valor sale en forma cerrada del inicio de la rampa (inicio + k * paso o
+// inicio * paso^k), asi que fill y skip dan lo mismo con cualquier troceado y
+// skip no depende de cuantos frames salta.
+class ParameterRamp
+{
+public:
+    enum class Shape { linear, exponential };
+
+    explicit ParameterRamp (Shape rampShape = Shape::linear) : shape (rampShape) {}
+
+    void reset (float value, int newRampLength)
+    {
+        current = target = start = value;
+        rampLength = newRampLength > 0 ? newRampLength : 1;
+        remaining = 0;
+    }
+
+    void setTarget (float newTarget)
+    {
+        if (newTarget == target)
+            return;
+
+        target = newTarget;
+        start = current;
+        elapsed = 0;
+        remaining = rampLength;
+
+        // Exponencial solo entre valores positivos; si no, rampa lineal hasta el objetivo
+        multiplicative = shape == Shape::exponential && current > 0.0f && target > 0.0f;
+
+        if (multiplicative)
+            step = std::pow (target / current, 1.0f / static_cast<float> (rampLength));
+        else
+            step = (target - current) / static_cast<float> (rampLength);
+    }
+
+    bool isRamping() const      { return remaining > 0; }
+    float getCurrent() const    { return current; }
+    float getTarget() const     { return target; }
+    int getRemaining() const    { return remaining; }
+
+    // Escribe numSamples valores en dest; el ultimo es el valor al final del bloque
+    void fill (float* dest, int numSamples)
+    {
+        int i = 0;
+
+        for (; i < numSamples && remaining > 0; ++i, --remaining)
+        {
+            current = getValueAt (++elapsed);
+            dest[i] = current;
+        }
+
+        if (remaining == 0)
+            current = target;
+
+        for (; i < numSamples; ++i)
+            dest[i] = current;
+    }
+
+    // Avanza sin buffer (rate por pasos del LFO, reposo): el mismo valor que
+    // habria dejado fill, sin recorrer los frames
+    float skip (int numSamples)
+    {
+        const int n = numSamples < remaining ? numSamples : remaining;
+        if (n <= 0)
+            return current;
+
+        elapsed += n;
+        remaining -= n;
+        current = remaining == 0 ? target : getValueAt (elapsed);
+        return current;
+    }
+
+private:
+    // La exponencial (rate) solo avanza con skip, una vez por paso del LFO
+    float getValueAt (int k) const
+    {
+        return multiplicative ? start * std::pow (step, static_cast<float> (k))
+                              : start + step * static_cast<float> (k);
+    }
+
+    Shape shape;
+    bool multiplicative = false;   // modo elegido por setTarget para la rampa en curso
+    float current = 0.0f;
+    float target = 0.0f;
+    float start = 0.0f;
+    float step = 0.0f;
+    int rampLength = 1;
+    int remaining = 0;
+    int elapsed = 0;
+};
@@ -8,7 +8,7 @@ KoruzAudioProcessorEditor::KoruzAudioProcessorEditor (KoruzAudioProcessor& p)
     rateSlider.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
     rateSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 70, 20);
     rateSlider.setRange(0.1, 2.0, 0.01);
-    rateSlider.setValue(0.8);
+    rateSlider.setValue(audioProcessor.getRateParam()->get());
     rateSlider.setTextValueSuffix(" Hz");
     rateSlider.setColour(juce::Slider::rotarySliderFillColourId, juce::Colour(0xffffd700));
     rateSlider.setColour(juce::Slider::rotarySliderOutlineColourId, juce::Colour(0xff555555));
@@ -30,7 +30,7 @@ KoruzAudioProcessorEditor::KoruzAudioProcessorEditor (KoruzAudioProcessor& p)
     depthSlider.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
     depthSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 70, 20);
     depthSlider.setRange(0.0, 100.0, 1.0);
-    depthSlider.setValue(40.0);
+    depthSlider.setValue(audioProcessor.getDepthParam()->get() * 100.0);
     depthSlider.setTextValueSuffix(" %");
     depthSlider.setColour(juce::Slider::rotarySliderFillColourId, juce::Colour(0xffff6b6b));
     depthSlider.setColour(juce::Slider::rotarySliderOutlineColourId, juce::Colour(0xff555555));
@@ -52,7 +52,7 @@ KoruzAudioProcessorEditor::KoruzAudioProcessorEditor (KoruzAudioProcessor& p)
     mixSlider.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
     mixSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 70, 20);
     mixSlider.setRange(0.0, 100.0, 1.0);
-    mixSlider.setValue(50.0);
+    mixSlider.setValue(audioProcessor.getMixParam()->get() * 100.0);
     mixSlider.setTextValueSuffix(" %");
     mixSlider.setColour(juce::Slider::rotarySliderFillColourId, juce::Colour(0xff4ecdc4));
     mixSlider.setColour(juce::Slider::rotarySliderOutlineColourId, juce::Colour(0xff555555));
@@ -70,6 +70,27 @@ KoruzAudioProcessorEditor::KoruzAudioProcessorEditor (KoruzAudioProcessor& p)
     mixLabel.setColour(juce::Label::textColourId, juce::Colour(0xff4ecdc4));
     addAndMakeVisible(mixLabel);
 
+    // Voices Slider - COLOR VIOLETA
+    voicesSlider.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
+    voicesSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 70, 20);
+    voicesSlider.setRange(1.0, 8.0, 1.0);
+    voicesSlider.setValue(audioProcessor.getVoicesParam()->get());
+    voicesSlider.setColour(juce::Slider::rotarySliderFillColourId, juce::Colour(0xffb388ff));
+    voicesSlider.setColour(juce::Slider::rotarySliderOutlineColourId, juce::Colour(0xff555555));
+    voicesSlider.setColour(juce::Slider::thumbColourId, juce::Colour(0xffa070ff));
+    voicesSlider.setColour(juce::Slider::textBoxTextColourId, juce::Colours::white);
+    voicesSlider.setColour(juce::Slider::textBoxBackgroundColourId, juce::Colour(0xaa333333));
+    addAndMakeVisible(voicesSlider);
+
+    voicesLabel.setText("VOICES", juce::dontSendNotification);
+    voicesLabel.setJustificationType(juce::Justification::centred);
+    juce::Font voicesFont;
+    voicesFont.setHeight(14.0f);
+    voicesFont.setBold(true);
+    voicesLabel.setFont(voicesFont);
+    voicesLabel.setColour(juce::Label::textColourId, juce::Colour(0xffb388ff));
+    addAndMakeVisible(voicesLabel);
+
     // Title Label - COLOR DORADO
     titleLabel.setText("KORUZ", juce::dontSendNotification);
     titleLabel.setJustificationType(juce::Justification::centred);
@@ -80,6 +101,31 @@ KoruzAudioProcessorEditor::KoruzAudioProcessorEditor (KoruzAudioProcessor& p)
     titleLabel.setColour(juce::Label::textColourId, juce::Colours::gold);
     addAndMakeVisible(titleLabel);
 
+    // Quality - Eco / Normal / HQ
+    qualityBox.addItemList(audioProcessor.getQualityParam()->choices, 1);
+    qualityBox.setSelectedItemIndex(audioProcessor.getQualityParam()->getIndex(), juce::dontSendNotification);
+    qualityBox.setJustificationType(juce::Justification::centred);
+    qualityBox.setColour(juce::ComboBox::backgroundColourId, juce::Colour(0xaa333333));
+    qualityBox.setColour(juce::ComboBox::textColourId, juce::Colours::gold);
+    qualityBox.setColour(juce::ComboBox::outlineColourId, juce::Colours::gold.withAlpha(0.6f));
+    qualityBox.setColour(juce::ComboBox::arrowColourId, juce::Colours::gold);
+    addAndMakeVisible(qualityBox);
+
+    // Carga de CPU y recorte del gobernador, bajo el selector de calidad
+    loadLabel.setJustificationType(juce::Justification::centred);
+    loadLabel.setFont(juce::Font(11.0f));
+    loadLabel.setColour(juce::Label::textColourId, juce::Colours::gold.withAlpha(0.7f));
+    addAndMakeVisible(loadLabel);
+    updateLoadLabel();
+
+   #if KORUZ_TRACE
+    traceButton.setButtonText("Dump trace");
+    traceButton.setColour(juce::TextButton::buttonColourId, juce::Colour(0xaa333333));
+    traceButton.setColour(juce::TextButton::textColourOffId, juce::Colours::gold);
+    traceButton.onClick = [this] { dumpTrace(); };
+    addAndMakeVisible(traceButton);
+   #endif
+
     // Configurar listeners
     rateSlider.onValueChange = [this] {
         audioProcessor.getRateParam()->setValueNotifyingHost(static_cast<float>(rateSlider.getValue()));
@@ -93,11 +139,20 @@ KoruzAudioProcessorEditor::KoruzAudioProcessorEditor (KoruzAudioProcessor& p)
         audioProcessor.getMixParam()->setValueNotifyingHost(static_cast<float>(mixSlider.getValue()) / 100.0f);
     };
 
+    qualityBox.onChange = [this] {
+        *audioProcessor.getQualityParam() = qualityBox.getSelectedItemIndex();
+    };
+
+    voicesSlider.onValueChange = [this] {
+        auto* voices = audioProcessor.getVoicesParam();
+        voices->setValueNotifyingHost(voices->convertTo0to1(static_cast<float>(voicesSlider.getValue())));
+    };
+
     setSize(500, 400); // Aumentado a 400px de alto para la animación
     setOpaque(true);
     
-    // Iniciar timer para animación (60 FPS)
-    startTimerHz(60);
+    // Iniciar timer para animación (60 FPS, baja en reposo)
+    startTimerHz(activeFrameRate);
 }
 
 KoruzAudioProcessorEditor::~KoruzAudioProcessorEditor()
@@ -107,29 +162,89 @@ KoruzAudioProcessorEditor::~KoruzAudioProcessorEditor()
 
 void KoruzAudioProcessorEditor::timerCallback()
 {
+    // Sin ventana visible no se dibuja nada, pero el timer sigue a ritmo bajo: al
+    // minimizar y restaurar el host no siempre llega visibilityChanged
+    if (! isShowing())
+    {
+        if (getTimerInterval() != 1000 / idleFrameRate)
+            startTimerHz(idleFrameRate);
+
+        stringWasMoving = true;   // un repintado al volver
+        return;
+    }
+
     updateStringAnimation();
-    repaint(); // Redibujar para animación
+    updateLoadLabel();
+
+    // Solo se invalida la zona de la cuerda, y solo si se mueve (o acaba de pararse)
+    const bool moving = stringAmplitude > 0.001f;
+    if (moving || stringWasMoving)
+        repaint(getAnimationArea());
+
+    stringWasMoving = moving;
+
+    // En reposo basta con un ritmo bajo para detectar que vuelve el audio
+    const int frameRate = moving ? activeFrameRate : idleFrameRate;
+    if (getTimerInterval() != 1000 / frameRate)
+        startTimerHz(frameRate);
+}
+
+void KoruzAudioProcessorEditor::updateTimerState()
+{
+    // Visible: ritmo completo hasta que la cuerda se pare; oculto: ritmo bajo, nunca parado
+    const int frameRate = isShowing() ? activeFrameRate : idleFrameRate;
+    if (! isTimerRunning() || getTimerInterval() != 1000 / frameRate)
+        startTimerHz(frameRate);
+}
+
+void KoruzAudioProcessorEditor::visibilityChanged()
+{
+    updateTimerState();
+}
+
+void KoruzAudioProcessorEditor::parentHierarchyChanged()
+{
+    updateTimerState();
 }
 
 void KoruzAudioProcessorEditor::updateStringAnimation()
 {
-    // Obtener parámetros actuales para la animación
-    float rate = static_cast<float>(rateSlider.getValue());
-    float depth = static_cast<float>(depthSlider.getValue()) / 100.0f;
-    float mix = static_cast<float>(mixSlider.getValue()) / 100.0f;
-    
-    // Actualizar fase de la animación basado en el rate
-    stringPhase += rate * stringAnimationSpeed * 0.01f;
-    if (stringPhase > juce::MathConstants<float>::twoPi) {
-        stringPhase -= juce::MathConstants<float>::twoPi;
+    // Vaciar la telemetría del audio; el pico se acumula entre frames
+    ChorusTelemetry block;
+    float blockPeak = 0.0f;
+    bool received = false;
+
+    while (audioProcessor.popTelemetry(block))
+    {
+        blockPeak = juce::jmax(blockPeak, block.peak);
+        latestTelemetry = block;
+        received = true;
     }
-    
-    // Calcular amplitud basado en depth y mix
-    stringAmplitude = depth * mix * 0.8f;
+
+    // Nivel con ataque inmediato y caída suave (también sin audio, p.ej. transporte parado)
+    const float level = received ? juce::jlimit(0.0f, 1.0f, 0.5f * blockPeak + 2.0f * latestTelemetry.rms) : 0.0f;
+    displayLevel = juce::jmax(level, displayLevel * 0.9f);
+
+    // La fase de la cuerda sigue al LFO real
+    stringPhase = latestTelemetry.lfoPhase * juce::MathConstants<float>::twoPi;
+
+    // Amplitud según el nivel de salida y cuánto se ha desplazado el delay (15-22ms)
+    const float modulation = juce::jlimit(0.0f, 1.0f, (latestTelemetry.delayMs - 15.0f) / 7.0f);
+    stringAmplitude = displayLevel * (0.3f + 0.7f * modulation);
 }
 
-void KoruzAudioProcessorEditor::paint (juce::Graphics& g)
+void KoruzAudioProcessorEditor::renderStaticLayers()
 {
+    // Capas fijas (fondo, panel, textos, línea base) en una imagen, una vez por tamaño
+    const float scale = juce::Component::getApproximateScaleFactorForComponent(this);
+    staticLayers = juce::Image(juce::Image::RGB,
+                               juce::jmax(1, juce::roundToInt(getWidth() * scale)),
+                               juce::jmax(1, juce::roundToInt(getHeight() * scale)), false);
+    staticLayersScale = scale;
+
+    juce::Graphics g(staticLayers);
+    g.addTransform(juce::AffineTransform::scale(scale));
+
     // Fondo con gradiente NEGRO a GRIS OSCURO
     juce::ColourGradient gradient(
         juce::Colour(0xff111111), 0, 0,
@@ -170,42 +285,71 @@ void KoruzAudioProcessorEditor::paint (juce::Graphics& g)
     g.setColour(juce::Colours::white.withAlpha(0.8f));
     g.drawText("Premium Chorus", getLocalBounds().removeFromTop(100).removeFromBottom(20), juce::Justification::centred);
 
-    // ANIMACIÓN DE CUERDA - Centro debajo de los knobs
-    int stringY = 280; // Posición Y de la cuerda
-    int stringWidth = getWidth() - 120;
-    int stringX = 60;
-    
-    // Dibujar línea base de la cuerda
+    // Línea base de la cuerda
+    const auto string = getStringBounds();
     g.setColour(juce::Colours::darkgrey.withAlpha(0.6f));
-    g.drawLine(stringX, stringY, stringX + stringWidth, stringY, 1.5f);
-    
+    g.drawLine(string.getX(), string.getCentreY(), string.getRight(), string.getCentreY(), 1.5f);
+
+    // Footer
+    juce::Font footerFont;
+    footerFont.setHeight(12.0f);
+    footerFont.setItalic(true);
+    g.setFont(footerFont);
+    g.setColour(juce::Colours::white.withAlpha(0.6f));
+    g.drawText("by David Signals", getLocalBounds().removeFromBottom(30), juce::Justification::centred);
+}
+
+juce::Rectangle<float> KoruzAudioProcessorEditor::getStringBounds() const
+{
+    // ANIMACIÓN DE CUERDA - Centro debajo de los knobs (altura cero, y = cuerda en reposo)
+    return { 60.0f, 280.0f, static_cast<float>(getWidth() - 120), 0.0f };
+}
+
+juce::Rectangle<int> KoruzAudioProcessorEditor::getAnimationArea() const
+{
+    // Cuerda (±15px), anclajes y partículas (hasta 42px por encima)
+    return getStringBounds().withTop(280.0f - 45.0f).withBottom(280.0f + 20.0f)
+                            .expanded(6.0f, 0.0f).getSmallestIntegerContainer();
+}
+
+void KoruzAudioProcessorEditor::paint (juce::Graphics& g)
+{
+    const float scale = juce::Component::getApproximateScaleFactorForComponent(this);
+    if (! staticLayers.isValid() || scale != staticLayersScale)
+        renderStaticLayers();
+
+    g.drawImage(staticLayers, getLocalBounds().toFloat());
+
+    const auto string = getStringBounds();
+    const float stringX = string.getX();
+    const float stringY = string.getCentreY();
+    const float stringWidth = string.getWidth();
+
     // Dibujar cuerda animada
     g.setColour(juce::Colours::gold.withAlpha(0.8f));
-    
-    const int numPoints = 20;
-    juce::Path stringPath;
-    
-    // Punto inicial
+
+    // Punto inicial; el Path se reutiliza para no reservar memoria en cada frame
+    stringPath.clear();
     stringPath.startNewSubPath(stringX, stringY);
-    
+
     // Crear puntos de la cuerda con onda sinusoidal
-    for (int i = 1; i < numPoints; ++i)
+    for (int i = 1; i < numStringPoints; ++i)
     {
-        float x = stringX + (stringWidth * i / static_cast<float>(numPoints - 1));
+        float x = stringX + (stringWidth * i / static_cast<float>(numStringPoints - 1));
         float wave = std::sin(stringPhase + (i * 0.3f));
         float y = stringY + wave * stringAmplitude * 15.0f;
-        
+
         stringPath.lineTo(x, y);
     }
-    
+
     // Dibujar la cuerda
     g.strokePath(stringPath, juce::PathStrokeType(2.0f));
-    
+
     // Dibujar puntos de anclaje
     g.setColour(juce::Colours::gold);
     g.fillEllipse(stringX - 3, stringY - 3, 6, 6);
     g.fillEllipse(stringX + stringWidth - 3, stringY - 3, 6, 6);
-    
+
     // Efecto de vibración (partículas de sonido)
     if (stringAmplitude > 0.1f)
     {
@@ -217,22 +361,16 @@ void KoruzAudioProcessorEditor::paint (juce::Graphics& g)
             g.fillEllipse(particleX - 2, particleY - 2, 4, 4);
         }
     }
-
-    // Footer
-    juce::Font footerFont;
-    footerFont.setHeight(12.0f);
-    footerFont.setItalic(true);
-    g.setFont(footerFont);
-    g.setColour(juce::Colours::white.withAlpha(0.6f));
-    g.drawText("by David Signals", getLocalBounds().removeFromBottom(30), juce::Justification::centred);
 }
 
 void KoruzAudioProcessorEditor::resized()
 {
-    int sliderSize = 90;
+    renderStaticLayers();
+
+    int sliderSize = 80;
     int labelHeight = 20;
-    int spacing = 25;
-    int totalWidth = sliderSize * 3 + spacing * 2;
+    int spacing = 20;
+    int totalWidth = sliderSize * 4 + spacing * 3;
     int startX = (getWidth() - totalWidth) / 2;
     int yPos = 110;
 
@@ -245,5 +383,49 @@ void KoruzAudioProcessorEditor::resized()
     mixSlider.setBounds(startX + 2 * (sliderSize + spacing), yPos, sliderSize, sliderSize);
     mixLabel.setBounds(startX + 2 * (sliderSize + spacing), yPos + sliderSize + 5, sliderSize, labelHeight);
 
+    voicesSlider.setBounds(startX + 3 * (sliderSize + spacing), yPos, sliderSize, sliderSize);
+    voicesLabel.setBounds(startX + 3 * (sliderSize + spacing), yPos + sliderSize + 5, sliderSize, labelHeight);
+
     titleLabel.setBounds(0, 15, getWidth(), 50);
+    qualityBox.setBounds(getWidth() - 110, 20, 90, 22);
+    loadLabel.setBounds(getWidth() - 110, 44, 90, 16);
+
+   #if KORUZ_TRACE
+    traceButton.setBounds(20, 20, 90, 22);
+   #endif
+}
+
+#if KORUZ_TRACE
+void KoruzAudioProcessorEditor::dumpTrace()
+{
+    // Un fichero por volcado; se abre en ui.perfetto.dev o chrome://tracing
+    const auto name = "Koruz-trace-" + juce::Time::getCurrentTime().formatted("%Y%m%d-%H%M%S") + ".json";
+    const auto file = juce::File::getSpecialLocation(juce::File::userDesktopDirectory).getChildFile(name);
+
+    if (KoruzTrace::writeChromeTrace(file.getFullPathName().toRawUTF8()))
+    {
+        traceButton.setTooltip(file.getFullPathName());
+        file.revealToUser();
+    }
+    else
+    {
+        traceButton.setTooltip("Could not write " + file.getFullPathName());
+    }
+}
+#endif
+
+void KoruzAudioProcessorEditor::updateLoadLabel()
+{
+    static const char* const tierNames[] = { " - auto", " - reduced", " - low", " - minimal" };
+
+    // Con el gobernador apagado solo se muestra la carga; encendido, tambien su nivel
+    const bool governorOn = audioProcessor.isGovernorEnabled();
+    const int tier = juce::jlimit(0, CpuGovernor::maxTier, audioProcessor.getLoadTier());
+    const auto text = "CPU " + juce::String(juce::roundToInt(audioProcessor.getCpuLoad() * 100.0f)) + "%"
+                    + (governorOn ? tierNames[tier] : "");
+
+    // setText ya solo repinta si cambia
+    loadLabel.setText(text, juce::dontSendNotification);
+    loadLabel.setTooltip(governorOn ? "CPU Governor on: quality steps down under load"
+                                    : "CPU Governor off");
 }
\ No newline at end of file
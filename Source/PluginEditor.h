@@ -2,6 +2,7 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "KoruzTrace.h"
 
 class KoruzAudioProcessorEditor  : public juce::AudioProcessorEditor,
                                    private juce::Timer  // ← Añade herencia de Timer
@@ -11,6 +12,8 @@ public:
     ~KoruzAudioProcessorEditor() override;
     void paint (juce::Graphics&) override;
     void resized() override;
+    void visibilityChanged() override;
+    void parentHierarchyChanged() override;
 
 private:
     KoruzAudioProcessor& audioProcessor;
@@ -18,18 +21,48 @@ private:
     juce::Slider rateSlider;
     juce::Slider depthSlider;
     juce::Slider mixSlider;
+    juce::Slider voicesSlider;
     
     juce::Label rateLabel;
     juce::Label depthLabel;
     juce::Label mixLabel;
+    juce::Label voicesLabel;
     juce::Label titleLabel;
 
+    juce::ComboBox qualityBox;
+    juce::Label loadLabel;
+
+   #if KORUZ_TRACE
+    // Solo en builds con trazas: vuelca el Chrome trace al escritorio
+    juce::TextButton traceButton;
+    void dumpTrace();
+   #endif
+
     // Variables para la animación de la cuerda
     float stringPhase = 0.0f;
     float stringAmplitude = 0.0f;
     juce::Time lastUpdateTime;
     const float stringAnimationSpeed = 0.3f;
 
+    // Ultimo bloque recibido del hilo de audio
+    ChorusTelemetry latestTelemetry;
+    float displayLevel = 0.0f;
+    bool stringWasMoving = true;
+
+    // Capas estáticas cacheadas y Path reutilizado para la cuerda
+    juce::Image staticLayers;
+    float staticLayersScale = 1.0f;
+    juce::Path stringPath;
+    static constexpr int numStringPoints = 20;
+    static constexpr int activeFrameRate = 60;
+    static constexpr int idleFrameRate = 10;
+
+    void renderStaticLayers();
+    juce::Rectangle<float> getStringBounds() const;
+    juce::Rectangle<int> getAnimationArea() const;
+    void updateTimerState();
+    void updateLoadLabel();
+
     // Timer para animación - QUITA EL 'override'
     void timerCallback() override;  // ← Solo esto, sin override aquí
     void updateStringAnimation();
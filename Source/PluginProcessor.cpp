@@ -1,7 +1,43 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "KoruzTrace.h"
 #include <JuceHeader.h>
 #include <cmath>
+#include <thread>
+
+namespace
+{
+    // Acceso exclusivo al motor sin bloquear nunca el hilo de audio
+    class ScopedEngineAccess
+    {
+    public:
+        // Hilo de audio: un solo intento
+        static ScopedEngineAccess tryAcquire (std::atomic<bool>& flag)
+        {
+            return ScopedEngineAccess (flag, ! flag.exchange (true, std::memory_order_acquire));
+        }
+
+        // prepare/release: espera como mucho al final del bloque en curso
+        static ScopedEngineAccess acquire (std::atomic<bool>& flag)
+        {
+            while (flag.exchange (true, std::memory_order_acquire))
+                std::this_thread::yield();
+
+            return ScopedEngineAccess (flag, true);
+        }
+
+        ScopedEngineAccess (const ScopedEngineAccess&) = delete;
+        ~ScopedEngineAccess() { if (owned) flag.store (false, std::memory_order_release); }
+
+        bool isOwned() const { return owned; }
+
+    private:
+        ScopedEngineAccess (std::atomic<bool>& f, bool isOwner) : flag (f), owned (isOwner) {}
+
+        std::atomic<bool>& flag;
+        bool owned;
+    };
+}
 
 KoruzAudioProcessor::KoruzAudioProcessor()
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -19,7 +55,7 @@ KoruzAudioProcessor::KoruzAudioProcessor()
     rateParam = std::make_unique<juce::AudioParameterFloat>(
         juce::ParameterID("rate", 1), 
         "Rate", 
-        juce::NormalisableRange<float>(0.1f, 2.0f, 0.01f), 
+        juce::NormalisableRange<float>(ChorusState::minRate, ChorusState::maxRate, 0.01f), 
         0.8f
     );
     addParameter(rateParam.get());
@@ -41,52 +77,130 @@ KoruzAudioProcessor::KoruzAudioProcessor()
         0.5f
     );
     addParameter(mixParam.get());
+
+    // Voices: 1 to 8 taps per channel
+    voicesParam = std::make_unique<juce::AudioParameterInt>(
+        juce::ParameterID("voices", 1), 
+        "Voices", 
+        1, ChorusEngine::maxVoices, 
+        1
+    );
+    addParameter(voicesParam.get());
+
+    // Quality: interpolation tier (Eco = linear, Normal = Catmull-Rom, HQ = 6-point Lagrange)
+    qualityParam = std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID("quality", 1), 
+        "Quality", 
+        juce::StringArray { "Eco", "Normal", "HQ" }, 
+        1
+    );
+    addParameter(qualityParam.get());
+
+    // Oversampled Clip: output knee at 2x (15 samples latency) or in the loop (none, default).
+    // Changes latency, so it is not automatable
+    clipOversamplingParam = std::make_unique<juce::AudioParameterBool>(
+        juce::ParameterID("clip2x", 1), 
+        "Oversampled Clip", 
+        false, 
+        juce::AudioParameterBoolAttributes().withAutomatable (false)
+    );
+    addParameter(clipOversamplingParam.get());
+    clipOversamplingParam->addListener (this);
+
+    // CPU Governor: steps quality down under realtime load (off by default, so
+    // quality never changes behind the user's back). Not automatable
+    cpuGovernorParam = std::make_unique<juce::AudioParameterBool>(
+        juce::ParameterID("governor", 1), 
+        "CPU Governor", 
+        false, 
+        juce::AudioParameterBoolAttributes().withAutomatable (false)
+    );
+    addParameter(cpuGovernorParam.get());
+
+    traceRing = KoruzTrace::claimRing (this);
+    engine.setTraceRing (traceRing);
 }
 
 KoruzAudioProcessor::~KoruzAudioProcessor()
 {
+    clipOversamplingParam->removeListener (this);
+    cancelPendingUpdate();
     releaseResources();
+    KoruzTrace::releaseRing (traceRing);
 }
 
 void KoruzAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
+    // El anillo solo se escribe con el motor tomado: la espera al bloque en curso no cuenta
+    const auto access = ScopedEngineAccess::acquire (engineBusy);
+    KORUZ_TRACE_SCOPE (traceRing, "prepareToPlay");
+
     currentSampleRate = sampleRate;
-    phase = 0.0f;
-    lfoSmoothed = 0.5f;
-    
-    releaseResources();
+    isPrepared = false;
     
     int numChannels = getTotalNumInputChannels();
     if (numChannels == 0) numChannels = 2;
     
-    // Buffer de delay optimizado (35ms)
-    int delayBufferSize = static_cast<int>(sampleRate * 0.035);
-    delayBufferSize = std::max(delayBufferSize, 1024);
-    
-    delayBuffers.clear();
-    writePositions.clear();
-    
-    for (int i = 0; i < numChannels; ++i)
-    {
-        delayBuffers.emplace_back(delayBufferSize, 0.0f);
-        writePositions.push_back(0);
-    }
+    // Valores actuales antes de preparar para no rampear desde los por defecto
+    engine.setParameters (getEngineParameters());
+    engine.setTailLength (getTailLengthSeconds());
+    engine.setClipOversampling (clipOversamplingParam->get());
+
+    float phaseOffsets[ChorusEngine::maxChannels];
+    for (int ch = 0; ch < ChorusEngine::maxChannels; ++ch)
+        phaseOffsets[ch] = ChorusEngine::getLayoutPhaseOffset (ch, numChannels);
+
+    engine.setChannelPhaseOffsets (phaseOffsets, numChannels);
+
+    // Memoria para el layout y el sample rate que anuncia el host; si crecen, aqui
+    // (fuera del hilo de audio) se reserva lo que falte y un prepare que cabe solo reparte
+    engine.prepare (sampleRate, numChannels, samplesPerBlock);
+    governor.prepare (sampleRate);
+
+    // Filtros de la rodilla a 2x (o nada sin ella); no depende del sample rate ni de la carga
+    setLatencySamples (engine.getLatencySamples());
     
     isPrepared = true;
 }
 
 void KoruzAudioProcessor::releaseResources()
 {
-    delayBuffers.clear();
-    writePositions.clear();
+    const auto access = ScopedEngineAccess::acquire (engineBusy);
+
+    engine.release();
     isPrepared = false;
 }
 
-void KoruzAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+void KoruzAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+{
+    processSamples (buffer);
+}
+
+// Hosts con motor de 64 bits: sin conversion a float y vuelta alrededor del plugin
+void KoruzAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer&)
+{
+    processSamples (buffer);
+}
+
+bool KoruzAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+template <typename SampleType>
+void KoruzAudioProcessor::processSamples (juce::AudioBuffer<SampleType>& buffer)
 {
     juce::ScopedNoDenormals noDenormals;
+
+    // Reconfiguracion en curso: el bloque pasa tal cual
+    const auto access = ScopedEngineAccess::tryAcquire (engineBusy);
+    if (!access.isOwned()) return;
+
+    KORUZ_TRACE_SCOPE (traceRing, "processBlock");
     
     if (!isPrepared) return;
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
         
     auto totalNumInputChannels = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -94,110 +208,126 @@ void KoruzAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear(i, 0, buffer.getNumSamples());
 
-    if (totalNumInputChannels == 0 || delayBuffers.empty()) return;
+    if (totalNumInputChannels == 0 || !engine.isPrepared()) return;
+
+    if (hasPendingLfoPhase.exchange (false, std::memory_order_acquire))
+        engine.setLfoPhase (pendingLfoPhase.load (std::memory_order_relaxed));
+
+    engine.setParameters (applyLoadTier (getEngineParameters(), loadTier.load (std::memory_order_relaxed)));
+    engine.process (buffer.getArrayOfWritePointers(),
+                    juce::jmin (totalNumInputChannels, buffer.getNumChannels()),
+                    buffer.getNumSamples());
+
+    skippedBlocks.store (engine.getSkippedBlocks(), std::memory_order_relaxed);
+    lfoPhase.store (engine.getLfoPhase(), std::memory_order_relaxed);
 
-    float rate = rateParam->get();
-    float depth = depthParam->get();
-    float mix = mixParam->get();
+    // TELEMETRÍA - sin locks ni memoria; si el editor no lee, se descarta
+    const int numSamples = buffer.getNumSamples();
+    const int numProcessed = juce::jmin (totalNumInputChannels, buffer.getNumChannels());
 
-    // ALGORITMO PROFESIONAL SIN NOISE
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
+    KORUZ_TRACE_SCOPE (traceRing, "telemetry + governor");
+
+    ChorusTelemetry block;
+    float sumOfSquares = 0.0f;
+    for (int ch = 0; ch < numProcessed; ++ch)
     {
-        if (channel >= delayBuffers.size()) continue;
-        
-        auto* channelData = buffer.getWritePointer(channel);
-        auto& delayData = delayBuffers[channel];
-        int& writePos = writePositions[channel];
-        const int delayBufferSize = static_cast<int>(delayData.size());
-        
-        if (delayBufferSize < 4) continue;
-        
-        for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
+        const auto rms = static_cast<float> (buffer.getRMSLevel (ch, 0, numSamples));
+        block.peak = juce::jmax (block.peak, static_cast<float> (buffer.getMagnitude (ch, 0, numSamples)));
+        sumOfSquares += rms * rms;
+    }
+
+    block.rms = numProcessed > 0 ? std::sqrt (sumOfSquares / static_cast<float> (numProcessed)) : 0.0f;
+    block.lfoPhase = static_cast<float> (engine.getLfoPhase());
+    block.delayMs = engine.getCurrentDelayMs();
+    telemetry.push (block);
+
+    // GOBERNADOR DE CPU - la carga se mide siempre; el nivel nuevo se aplica en el
+    // siguiente bloque y solo con el parametro activo. En render offline no hay
+    // presupuesto que cumplir
+    if (! isNonRealtime())
+    {
+        governor.setThreshold (governorThreshold.load (std::memory_order_relaxed));
+        governor.update (juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks),
+                         numSamples);
+    }
+    else
+    {
+        governor.reset();
+    }
+
+    loadTier.store (cpuGovernorParam->get() ? governor.getTier() : 0, std::memory_order_relaxed);
+    cpuLoad.store (governor.getLoad(), std::memory_order_relaxed);
+}
+
+void KoruzAudioProcessor::parameterValueChanged (int, float)
+{
+    triggerAsyncUpdate();
+}
+
+void KoruzAudioProcessor::handleAsyncUpdate()
+{
+    // Como prepareToPlay: espera al bloque en curso y el siguiente ya sale con el modo nuevo
+    {
+        const auto access = ScopedEngineAccess::acquire (engineBusy);
+
+        if (engine.isClipOversampling() == clipOversamplingParam->get())
+            return;
+
+        engine.setClipOversampling (clipOversamplingParam->get());
+    }
+
+    setLatencySamples (engine.getLatencySamples());
+}
+
+ChorusEngine::Interpolation KoruzAudioProcessor::qualityToInterpolation (int qualityIndex)
+{
+    switch (qualityIndex)
+    {
+        case 0:  return ChorusEngine::Interpolation::linear;
+        case 2:  return ChorusEngine::Interpolation::lagrange;
+        default: return ChorusEngine::Interpolation::catmullRom;
+    }
+}
+
+ChorusEngine::Parameters KoruzAudioProcessor::applyLoadTier (ChorusEngine::Parameters params, int tier)
+{
+    if (tier >= 1)
+    {
+        switch (params.interpolation)
         {
-            const float inputSample = channelData[sample];
-            
-            // LFO ULTRA SUAVE CON ANTI-ALIASING
-            phase += static_cast<float>(rate / currentSampleRate);
-            if (phase >= 1.0f) phase -= 1.0f;
-            
-            // LFO con forma de seno suavizado
-            float lfoValue = 0.5f + 0.5f * std::sin(2.0f * juce::MathConstants<float>::pi * phase);
-            
-            // Suavizado exponencial del LFO
-            lfoSmoothed = 0.9995f * lfoSmoothed + 0.0005f * lfoValue;
-            
-            // CURVA DE DEPTH OPTIMIZADA
-            float depthCurve = depth * depth;
-            float modulatedDepth = depthCurve * lfoSmoothed;
-            
-            // RANGO MUSICAL OPTIMIZADO: 8-22ms
-            const float baseDelayMs = 15.0f;
-            const float depthRangeMs = 7.0f;
-            float delayTimeMs = baseDelayMs + depthRangeMs * modulatedDepth;
-            
-            float delayTimeSamples = delayTimeMs * static_cast<float>(currentSampleRate) / 1000.0f;
-            
-            // LIMITACIÓN INTELIGENTE
-            delayTimeSamples = juce::jlimit(10.0f, static_cast<float>(delayBufferSize - 10), delayTimeSamples);
-            
-            // ESCRITURA EN BUFFER
-            delayData[writePos] = inputSample * 0.999f;
-            
-            // CÁLCULO DE POSICIÓN DE LECTURA
-            float readPosition = writePos - delayTimeSamples;
-            while (readPosition < 0) readPosition += delayBufferSize;
-            while (readPosition >= delayBufferSize) readPosition -= delayBufferSize;
-            
-            // INTERPOLACIÓN CÚBICA DE 4 PUNTOS
-            int idx0 = static_cast<int>(readPosition) - 1;
-            if (idx0 < 0) idx0 += delayBufferSize;
-            int idx1 = static_cast<int>(readPosition);
-            int idx2 = (idx1 + 1) % delayBufferSize;
-            int idx3 = (idx2 + 1) % delayBufferSize;
-            
-            float frac = readPosition - idx1;
-            
-            // Coeficientes Catmull-Rom
-            float y0 = delayData[idx0];
-            float y1 = delayData[idx1];
-            float y2 = delayData[idx2];
-            float y3 = delayData[idx3];
-            
-            float c0 = y1;
-            float c1 = 0.5f * (y2 - y0);
-            float c2 = y0 - 2.5f * y1 + 2.0f * y2 - 0.5f * y3;
-            float c3 = 0.5f * (y3 - y0) + 1.5f * (y1 - y2);
-            
-            float delayedSample = c0 + c1 * frac + c2 * frac * frac + c3 * frac * frac * frac;
-            
-            // SUAVIZADO ADAPTATIVO
-            float adaptiveSmoothing = 1.0f;
-            if (depth > 0.3f) {
-                float depthFactor = (depth - 0.3f) / 0.7f;
-                adaptiveSmoothing = 1.0f - depthFactor * 0.2f;
-            }
-            delayedSample *= adaptiveSmoothing;
-            
-            // MEZCLA DRY/WET OPTIMIZADA
-            float wetGain = mix * 0.95f;
-            float dryGain = 1.0f - mix;
-            
-            float outputSample = (inputSample * dryGain) + (delayedSample * wetGain);
-            
-            // PROTECCIÓN CONTRA CLIPPING
-            const float threshold = 0.99f;
-            if (outputSample > threshold) {
-                outputSample = threshold + (outputSample - threshold) * 0.3f;
-            } else if (outputSample < -threshold) {
-                outputSample = -threshold + (outputSample + threshold) * 0.3f;
-            }
-            
-            channelData[sample] = outputSample;
-            
-            // ACTUALIZACIÓN DE POSICIÓN
-            writePos = (writePos + 1) % delayBufferSize;
+            case ChorusEngine::Interpolation::lagrange:   params.interpolation = ChorusEngine::Interpolation::catmullRom; break;
+            case ChorusEngine::Interpolation::catmullRom:
+            case ChorusEngine::Interpolation::allpass:    params.interpolation = ChorusEngine::Interpolation::linear; break;
+            case ChorusEngine::Interpolation::linear:     break;
         }
     }
+
+    if (tier >= 2)
+    {
+        params.interpolation = ChorusEngine::Interpolation::linear;
+        params.voices = tier >= 3 ? 1 : (params.voices + 1) / 2;
+    }
+
+    return params;
+}
+
+ChorusEngine::Parameters KoruzAudioProcessor::getEngineParameters() const
+{
+    ChorusEngine::Parameters params;
+    params.rate = rateParam->get();
+    params.depth = depthParam->get();
+    params.mix = mixParam->get();
+    params.voices = voicesParam->get();
+    params.interpolation = qualityToInterpolation (qualityParam->getIndex());
+    return params;
+}
+
+ChorusEngine::MemoryUsage KoruzAudioProcessor::getMemoryUsage() const
+{
+    // El motor ya cuenta su sizeof; aqui solo se suma el resto del procesador
+    auto usage = engine.getMemoryUsage();
+    usage.instanceBytes += sizeof (KoruzAudioProcessor) - sizeof (ChorusEngine);
+    return usage;
 }
 
 // Resto de funciones JUCE
@@ -215,8 +345,9 @@ void KoruzAudioProcessor::changeProgramName (int index, const juce::String& newN
 #ifndef JucePlugin_PreferredChannelConfigurations
 bool KoruzAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
 {
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono() &&
-        layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Mono, stereo y surround hasta 7.1.4: todos los canales en un mismo motor
+    const auto mainOutput = layouts.getMainOutputChannelSet();
+    if (mainOutput.isDisabled() || mainOutput.size() > maxNumChannels)
         return false;
     
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
@@ -238,10 +369,50 @@ bool KoruzAudioProcessor::hasEditor() const
 
 void KoruzAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
+    ChorusState state;
+    state.parameters = getEngineParameters();
+    state.clipOversampling = clipOversamplingParam->get();
+    state.cpuGovernor = cpuGovernorParam->get();
+    state.hasLfoPhase = includeLfoPhaseInState.load (std::memory_order_relaxed);
+    state.lfoPhase = lfoPhase.load (std::memory_order_relaxed);
+
+    std::array<std::uint8_t, ChorusState::maxSize> bytes;
+    destData.replaceAll (bytes.data(), state.write (bytes.data(), bytes.size()));
 }
 
 void KoruzAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
+    // Sin memoria dinamica: se parte de los valores actuales y solo cambian los campos presentes
+    ChorusState state;
+    state.parameters = getEngineParameters();
+    state.clipOversampling = clipOversamplingParam->get();
+    state.cpuGovernor = cpuGovernorParam->get();
+
+    if (sizeInBytes <= 0 || ! state.read (data, static_cast<size_t> (sizeInBytes)))
+        return;
+
+    *rateParam = state.parameters.rate;
+    *depthParam = state.parameters.depth;
+    *mixParam = state.parameters.mix;
+    *voicesParam = state.parameters.voices;
+    *clipOversamplingParam = state.clipOversampling;
+    *cpuGovernorParam = state.cpuGovernor;
+
+    // El allpass no es una calidad del plugin: si llega en un estado se deja la actual
+    switch (state.parameters.interpolation)
+    {
+        case ChorusEngine::Interpolation::linear:     *qualityParam = 0; break;
+        case ChorusEngine::Interpolation::catmullRom: *qualityParam = 1; break;
+        case ChorusEngine::Interpolation::lagrange:   *qualityParam = 2; break;
+        case ChorusEngine::Interpolation::allpass:    break;
+    }
+
+    // La fase se aplica en el hilo de audio al inicio del siguiente bloque
+    if (state.hasLfoPhase)
+    {
+        pendingLfoPhase.store (state.lfoPhase, std::memory_order_relaxed);
+        hasPendingLfoPhase.store (true, std::memory_order_release);
+    }
 }
 
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
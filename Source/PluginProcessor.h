@@ -1,10 +1,18 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "ChorusEngine.h"
+#include "ChorusState.h"
+#include "CpuGovernor.h"
+#include "TelemetryRing.h"
 
-class KoruzAudioProcessor  : public juce::AudioProcessor
+class KoruzAudioProcessor  : public juce::AudioProcessor,
+                             private juce::AudioProcessorParameter::Listener,
+                             private juce::AsyncUpdater
 {
 public:
+    static constexpr int maxNumChannels = 12;   // hasta 7.1.4, el mayor layout aceptado
+
     KoruzAudioProcessor();
     ~KoruzAudioProcessor() override;
 
@@ -16,6 +24,8 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override;
     const juce::String getName() const override;
@@ -35,22 +45,84 @@ public:
     juce::AudioParameterFloat* getRateParam() { return rateParam.get(); }
     juce::AudioParameterFloat* getDepthParam() { return depthParam.get(); }
     juce::AudioParameterFloat* getMixParam() { return mixParam.get(); }
+    juce::AudioParameterInt* getVoicesParam() { return voicesParam.get(); }
+    juce::AudioParameterChoice* getQualityParam() { return qualityParam.get(); }
+    juce::AudioParameterBool* getClipOversamplingParam() { return clipOversamplingParam.get(); }
+    juce::AudioParameterBool* getCpuGovernorParam() { return cpuGovernorParam.get(); }
+
+    static ChorusEngine::Interpolation qualityToInterpolation (int qualityIndex);
+
+    // Recorte de calidad por carga: 1 = interpolacion un escalon por debajo,
+    // 2 = lineal y la mitad de voces, 3 = lineal y una voz
+    static ChorusEngine::Parameters applyLoadTier (ChorusEngine::Parameters params, int tier);
+
+    // Gobernador de CPU (legible desde cualquier hilo): la carga se mide siempre en
+    // tiempo real, el nivel solo se aplica con el parametro CPU Governor; offline no actua
+    int getLoadTier() const { return loadTier.load (std::memory_order_relaxed); }
+    float getCpuLoad() const { return cpuLoad.load (std::memory_order_relaxed); }
+    bool isGovernorEnabled() const { return cpuGovernorParam->get(); }
+    void setCpuBudgetThreshold (float fractionOfBudget) { governorThreshold.store (fractionOfBudget); }
+    void setGovernorEnabled (bool shouldBeEnabled) { *cpuGovernorParam = shouldBeEnabled; }
+
+    // Bloques en los que el chorus estaba en reposo por silencio (legible desde cualquier hilo)
+    juce::uint64 getSkippedBlockCount() const { return skippedBlocks.load (std::memory_order_relaxed); }
+
+    // Memoria de esta instancia (procesador + motor) y del workspace compartido (no desde el hilo de audio)
+    ChorusEngine::MemoryUsage getMemoryUsage() const;
+
+    // Guardar tambien la fase del LFO en el estado, para renders repetibles
+    void setIncludeLfoPhaseInState (bool shouldInclude) { includeLfoPhaseInState.store (shouldInclude); }
+
+    // Telemetria por bloque para el editor; solo debe llamarse desde un unico hilo (el timer del editor)
+    bool popTelemetry (ChorusTelemetry& item) { return telemetry.pop (item); }
 
 private:
+    ChorusEngine::Parameters getEngineParameters() const;
+
+    // Cuerpo comun de los dos processBlock
+    template <typename SampleType>
+    void processSamples (juce::AudioBuffer<SampleType>& buffer);
+
+    // Rodilla a 2x: el cambio (desde cualquier hilo) se aplica en el de mensajes,
+    // donde se puede reportar la latencia nueva
+    void parameterValueChanged (int parameterIndex, float newValue) override;
+    void parameterGestureChanged (int, bool) override {}
+    void handleAsyncUpdate() override;
+
     // Chorus parameters
     std::unique_ptr<juce::AudioParameterFloat> rateParam;
     std::unique_ptr<juce::AudioParameterFloat> depthParam;
     std::unique_ptr<juce::AudioParameterFloat> mixParam;
+    std::unique_ptr<juce::AudioParameterInt> voicesParam;
+    std::unique_ptr<juce::AudioParameterChoice> qualityParam;
+    std::unique_ptr<juce::AudioParameterBool> clipOversamplingParam;
+    std::unique_ptr<juce::AudioParameterBool> cpuGovernorParam;
 
-    // Chorus variables
+    // Chorus DSP (sin JUCE), procesa todos los canales en carriles SIMD
+    ChorusEngine engine;
     double currentSampleRate = 44100.0;
-    float phase = 0.0f;
-    float lfoSmoothed = 0.5f;  // ← AÑADE ESTA LÍNEA
-    
-    // Delay buffer - usando std::vector para mayor seguridad
-    std::vector<std::vector<float>> delayBuffers;
-    std::vector<int> writePositions;
     bool isPrepared = false;
 
+    // Dueno actual del motor: el hilo de audio solo lo intenta tomar y, si
+    // prepare/release lo tienen, deja pasar el bloque sin procesar
+    std::atomic<bool> engineBusy { false };
+    std::atomic<juce::uint64> skippedBlocks { 0 };
+
+    // Anillo de trazas (KORUZ_TRACE): solo se escribe con engineBusy tomado
+    TraceRing* traceRing = nullptr;
+    TelemetryRing<ChorusTelemetry, 64> telemetry;
+
+    // Tiempo de processBlock frente al presupuesto del bloque
+    CpuGovernor governor;
+    std::atomic<int> loadTier { 0 };
+    std::atomic<float> cpuLoad { 0.0f };
+    std::atomic<float> governorThreshold { 0.25f };
+
+    // Fase del LFO publicada por el audio y fase pendiente de un estado cargado
+    std::atomic<double> lfoPhase { 0.0 };
+    std::atomic<double> pendingLfoPhase { 0.0 };
+    std::atomic<bool> hasPendingLfoPhase { false };
+    std::atomic<bool> includeLfoPhaseInState { false };
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (KoruzAudioProcessor)
 };
\ No newline at end of file
@@ -0,0 +1,236 @@
+#pragma once
+
+// Vectores SIMD minimos para el DSP de Koruz (sin dependencias de JUCE).
+// Float4: SSE2 en x86, NEON en ARM, escalar en el resto.
+// Float8: AVX si el compilador lo habilita, si no dos Float4.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #define KORUZ_SIMD_SSE 1
+ #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+ #define KORUZ_SIMD_NEON 1
+ #include <arm_neon.h>
+#endif
+
+#if defined(__AVX__)
+ #define KORUZ_SIMD_AVX 1
+ #include <immintrin.h>
+#endif
+
+#if defined(__AVX2__)
+ #define KORUZ_SIMD_AVX2 1
+#endif
+
+#if defined(_MSC_VER)
+ #define KORUZ_INLINE __forceinline
+#else
+ #define KORUZ_INLINE inline __attribute__((always_inline))
+#endif
+
+struct Float4
+{
+    static constexpr int width = 4;
+
+   #if KORUZ_SIMD_SSE
+    __m128 v;
+
+    static KORUZ_INLINE Float4 load (const float* p)     { return { _mm_loadu_ps (p) }; }
+    static KORUZ_INLINE Float4 broadcast (float x)       { return { _mm_set1_ps (x) }; }
+    KORUZ_INLINE void store (float* p) const             { _mm_storeu_ps (p, v); }
+
+    friend KORUZ_INLINE Float4 operator+ (Float4 a, Float4 b) { return { _mm_add_ps (a.v, b.v) }; }
+    friend KORUZ_INLINE Float4 operator- (Float4 a, Float4 b) { return { _mm_sub_ps (a.v, b.v) }; }
+    friend KORUZ_INLINE Float4 operator* (Float4 a, Float4 b) { return { _mm_mul_ps (a.v, b.v) }; }
+    friend KORUZ_INLINE Float4 operator/ (Float4 a, Float4 b) { return { _mm_div_ps (a.v, b.v) }; }
+
+    static KORUZ_INLINE Float4 min (Float4 a, Float4 b)    { return { _mm_min_ps (a.v, b.v) }; }
+    static KORUZ_INLINE Float4 max (Float4 a, Float4 b)    { return { _mm_max_ps (a.v, b.v) }; }
+    static KORUZ_INLINE Float4 truncate (Float4 a)         { return { _mm_cvtepi32_ps (_mm_cvttps_epi32 (a.v)) }; }
+    KORUZ_INLINE void storeTruncated (int* p) const        { _mm_storeu_si128 (reinterpret_cast<__m128i*> (p), _mm_cvttps_epi32 (v)); }
+
+    // Traspone la matriz 4x4 cuyas filas son a, b, c, d
+    static KORUZ_INLINE void transpose (Float4& a, Float4& b, Float4& c, Float4& d) { _MM_TRANSPOSE4_PS (a.v, b.v, c.v, d.v); }
+
+    // Mascaras: todos los bits a 1 donde la comparacion es cierta
+    static KORUZ_INLINE Float4 greaterThan (Float4 a, Float4 b) { return { _mm_cmpgt_ps (a.v, b.v) }; }
+    static KORUZ_INLINE Float4 lessThan (Float4 a, Float4 b)    { return { _mm_cmplt_ps (a.v, b.v) }; }
+    static KORUZ_INLINE Float4 select (Float4 mask, Float4 a, Float4 b)
+    {
+        return { _mm_or_ps (_mm_and_ps (mask.v, a.v), _mm_andnot_ps (mask.v, b.v)) };
+    }
+   #elif KORUZ_SIMD_NEON
+    float32x4_t v;
+
+    static KORUZ_INLINE Float4 load (const float* p)     { return { vld1q_f32 (p) }; }
+    static KORUZ_INLINE Float4 broadcast (float x)       { return { vdupq_n_f32 (x) }; }
+    KORUZ_INLINE void store (float* p) const             { vst1q_f32 (p, v); }
+
+    friend KORUZ_INLINE Float4 operator+ (Float4 a, Float4 b) { return { vaddq_f32 (a.v, b.v) }; }
+    friend KORUZ_INLINE Float4 operator- (Float4 a, Float4 b) { return { vsubq_f32 (a.v, b.v) }; }
+    friend KORUZ_INLINE Float4 operator* (Float4 a, Float4 b) { return { vmulq_f32 (a.v, b.v) }; }
+   #if defined(__aarch64__) || defined(_M_ARM64)
+    friend KORUZ_INLINE Float4 operator/ (Float4 a, Float4 b) { return { vdivq_f32 (a.v, b.v) }; }
+   #else
+    friend KORUZ_INLINE Float4 operator/ (Float4 a, Float4 b)
+    {
+        float x[4], y[4];
+        vst1q_f32 (x, a.v);
+        vst1q_f32 (y, b.v);
+        for (int i = 0; i < 4; ++i) x[i] /= y[i];
+        return { vld1q_f32 (x) };
+    }
+   #endif
+
+    static KORUZ_INLINE Float4 min (Float4 a, Float4 b)    { return { vminq_f32 (a.v, b.v) }; }
+    static KORUZ_INLINE Float4 max (Float4 a, Float4 b)    { return { vmaxq_f32 (a.v, b.v) }; }
+    static KORUZ_INLINE Float4 truncate (Float4 a)         { return { vcvtq_f32_s32 (vcvtq_s32_f32 (a.v)) }; }
+    KORUZ_INLINE void storeTruncated (int* p) const        { vst1q_s32 (p, vcvtq_s32_f32 (v)); }
+
+    static KORUZ_INLINE void transpose (Float4& a, Float4& b, Float4& c, Float4& d)
+    {
+        const auto ab = vtrnq_f32 (a.v, b.v);   // a0 b0 a2 b2 | a1 b1 a3 b3
+        const auto cd = vtrnq_f32 (c.v, d.v);
+        a.v = vcombine_f32 (vget_low_f32 (ab.val[0]),  vget_low_f32 (cd.val[0]));
+        b.v = vcombine_f32 (vget_low_f32 (ab.val[1]),  vget_low_f32 (cd.val[1]));
+        c.v = vcombine_f32 (vget_high_f32 (ab.val[0]), vget_high_f32 (cd.val[0]));
+        d.v = vcombine_f32 (vget_high_f32 (ab.val[1]), vget_high_f32 (cd.val[1]));
+    }
+
+    static KORUZ_INLINE Float4 greaterThan (Float4 a, Float4 b) { return { vreinterpretq_f32_u32 (vcgtq_f32 (a.v, b.v)) }; }
+    static KORUZ_INLINE Float4 lessThan (Float4 a, Float4 b)    { return { vreinterpretq_f32_u32 (vcltq_f32 (a.v, b.v)) }; }
+    static KORUZ_INLINE Float4 select (Float4 mask, Float4 a, Float4 b)
+    {
+        return { vbslq_f32 (vreinterpretq_u32_f32 (mask.v), a.v, b.v) };
+    }
+   #else
+    float v[4];
+
+    static KORUZ_INLINE Float4 load (const float* p)     { return { { p[0], p[1], p[2], p[3] } }; }
+    static KORUZ_INLINE Float4 broadcast (float x)       { return { { x, x, x, x } }; }
+    KORUZ_INLINE void store (float* p) const             { for (int i = 0; i < 4; ++i) p[i] = v[i]; }
+
+    friend KORUZ_INLINE Float4 operator+ (Float4 a, Float4 b) { Float4 r; for (int i = 0; i < 4; ++i) r.v[i] = a.v[i] + b.v[i]; return r; }
+    friend KORUZ_INLINE Float4 operator- (Float4 a, Float4 b) { Float4 r; for (int i = 0; i < 4; ++i) r.v[i] = a.v[i] - b.v[i]; return r; }
+    friend KORUZ_INLINE Float4 operator* (Float4 a, Float4 b) { Float4 r; for (int i = 0; i < 4; ++i) r.v[i] = a.v[i] * b.v[i]; return r; }
+    friend KORUZ_INLINE Float4 operator/ (Float4 a, Float4 b) { Float4 r; for (int i = 0; i < 4; ++i) r.v[i] = a.v[i] / b.v[i]; return r; }
+
+    static KORUZ_INLINE Float4 min (Float4 a, Float4 b)    { Float4 r; for (int i = 0; i < 4; ++i) r.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i]; return r; }
+    static KORUZ_INLINE Float4 max (Float4 a, Float4 b)    { Float4 r; for (int i = 0; i < 4; ++i) r.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i]; return r; }
+    static KORUZ_INLINE Float4 truncate (Float4 a)         { Float4 r; for (int i = 0; i < 4; ++i) r.v[i] = static_cast<float> (static_cast<int> (a.v[i])); return r; }
+    KORUZ_INLINE void storeTruncated (int* p) const        { for (int i = 0; i < 4; ++i) p[i] = static_cast<int> (v[i]); }
+
+    static KORUZ_INLINE void transpose (Float4& a, Float4& b, Float4& c, Float4& d)
+    {
+        const Float4 rows[4] = { a, b, c, d };
+        Float4* columns[4] = { &a, &b, &c, &d };
+        for (int i = 0; i < 4; ++i)
+            for (int j = 0; j < 4; ++j)
+                columns[i]->v[j] = rows[j].v[i];
+    }
+
+    // En escalar la mascara es 1.0f / 0.0f
+    static KORUZ_INLINE Float4 greaterThan (Float4 a, Float4 b) { Float4 r; for (int i = 0; i < 4; ++i) r.v[i] = a.v[i] > b.v[i] ? 1.0f : 0.0f; return r; }
+    static KORUZ_INLINE Float4 lessThan (Float4 a, Float4 b)    { Float4 r; for (int i = 0; i < 4; ++i) r.v[i] = a.v[i] < b.v[i] ? 1.0f : 0.0f; return r; }
+    static KORUZ_INLINE Float4 select (Float4 mask, Float4 a, Float4 b)
+    {
+        Float4 r;
+        for (int i = 0; i < 4; ++i) r.v[i] = mask.v[i] != 0.0f ? a.v[i] : b.v[i];
+        return r;
+    }
+   #endif
+};
+
+struct Float8
+{
+    static constexpr int width = 8;
+
+   #if KORUZ_SIMD_AVX
+    __m256 v;
+
+    static KORUZ_INLINE Float8 load (const float* p)     { return { _mm256_loadu_ps (p) }; }
+    static KORUZ_INLINE Float8 broadcast (float x)       { return { _mm256_set1_ps (x) }; }
+    static KORUZ_INLINE Float8 combine (Float4 lo, Float4 hi) { return { _mm256_insertf128_ps (_mm256_castps128_ps256 (lo.v), hi.v, 1) }; }
+    KORUZ_INLINE void store (float* p) const             { _mm256_storeu_ps (p, v); }
+
+    friend KORUZ_INLINE Float8 operator+ (Float8 a, Float8 b) { return { _mm256_add_ps (a.v, b.v) }; }
+    friend KORUZ_INLINE Float8 operator- (Float8 a, Float8 b) { return { _mm256_sub_ps (a.v, b.v) }; }
+    friend KORUZ_INLINE Float8 operator* (Float8 a, Float8 b) { return { _mm256_mul_ps (a.v, b.v) }; }
+    friend KORUZ_INLINE Float8 operator/ (Float8 a, Float8 b) { return { _mm256_div_ps (a.v, b.v) }; }
+
+    static KORUZ_INLINE Float8 min (Float8 a, Float8 b)    { return { _mm256_min_ps (a.v, b.v) }; }
+    static KORUZ_INLINE Float8 max (Float8 a, Float8 b)    { return { _mm256_max_ps (a.v, b.v) }; }
+    static KORUZ_INLINE Float8 truncate (Float8 a)         { return { _mm256_round_ps (a.v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC) }; }
+    KORUZ_INLINE void storeTruncated (int* p) const        { _mm256_storeu_si256 (reinterpret_cast<__m256i*> (p), _mm256_cvttps_epi32 (v)); }
+
+    // Un float por carril: base[offsets[carril]]
+    static KORUZ_INLINE Float8 gather (const float* base, const int* offsets)
+    {
+       #if KORUZ_SIMD_AVX2
+        return { _mm256_i32gather_ps (base, _mm256_loadu_si256 (reinterpret_cast<const __m256i*> (offsets)), 4) };
+       #else
+        return { _mm256_setr_ps (base[offsets[0]], base[offsets[1]], base[offsets[2]], base[offsets[3]],
+                                 base[offsets[4]], base[offsets[5]], base[offsets[6]], base[offsets[7]]) };
+       #endif
+    }
+
+    static KORUZ_INLINE Float8 greaterThan (Float8 a, Float8 b) { return { _mm256_cmp_ps (a.v, b.v, _CMP_GT_OQ) }; }
+    static KORUZ_INLINE Float8 lessThan (Float8 a, Float8 b)    { return { _mm256_cmp_ps (a.v, b.v, _CMP_LT_OQ) }; }
+    static KORUZ_INLINE Float8 select (Float8 mask, Float8 a, Float8 b) { return { _mm256_blendv_ps (b.v, a.v, mask.v) }; }
+   #else
+    Float4 lo, hi;
+
+    static KORUZ_INLINE Float8 load (const float* p)     { return { Float4::load (p), Float4::load (p + 4) }; }
+    static KORUZ_INLINE Float8 broadcast (float x)       { return { Float4::broadcast (x), Float4::broadcast (x) }; }
+    static KORUZ_INLINE Float8 combine (Float4 lo, Float4 hi) { return { lo, hi }; }
+    KORUZ_INLINE void store (float* p) const             { lo.store (p); hi.store (p + 4); }
+
+    friend KORUZ_INLINE Float8 operator+ (Float8 a, Float8 b) { return { a.lo + b.lo, a.hi + b.hi }; }
+    friend KORUZ_INLINE Float8 operator- (Float8 a, Float8 b) { return { a.lo - b.lo, a.hi - b.hi }; }
+    friend KORUZ_INLINE Float8 operator* (Float8 a, Float8 b) { return { a.lo * b.lo, a.hi * b.hi }; }
+    friend KORUZ_INLINE Float8 operator/ (Float8 a, Float8 b) { return { a.lo / b.lo, a.hi / b.hi }; }
+
+    static KORUZ_INLINE Float8 min (Float8 a, Float8 b)    { return { Float4::min (a.lo, b.lo), Float4::min (a.hi, b.hi) }; }
+    static KORUZ_INLINE Float8 max (Float8 a, Float8 b)    { return { Float4::max (a.lo, b.lo), Float4::max (a.hi, b.hi) }; }
+    static KORUZ_INLINE Float8 truncate (Float8 a)         { return { Float4::truncate (a.lo), Float4::truncate (a.hi) }; }
+    KORUZ_INLINE void storeTruncated (int* p) const        { lo.storeTruncated (p); hi.storeTruncated (p + 4); }
+
+    // Un float por carril: base[offsets[carril]]
+    static KORUZ_INLINE Float8 gather (const float* base, const int* offsets)
+    {
+        const float lanes[8] = { base[offsets[0]], base[offsets[1]], base[offsets[2]], base[offsets[3]],
+                                 base[offsets[4]], base[offsets[5]], base[offsets[6]], base[offsets[7]] };
+        return load (lanes);
+    }
+
+    static KORUZ_INLINE Float8 greaterThan (Float8 a, Float8 b) { return { Float4::greaterThan (a.lo, b.lo), Float4::greaterThan (a.hi, b.hi) }; }
+    static KORUZ_INLINE Float8 lessThan (Float8 a, Float8 b)    { return { Float4::lessThan (a.lo, b.lo), Float4::lessThan (a.hi, b.hi) }; }
+    static KORUZ_INLINE Float8 select (Float8 mask, Float8 a, Float8 b)
+    {
+        return { Float4::select (mask.lo, a.lo, b.lo), Float4::select (mask.hi, a.hi, b.hi) };
+    }
+   #endif
+};
+
+// Flush-to-zero/denormals-are-zero mientras vive el objeto. El plugin ya usa
+// juce::ScopedNoDenormals; esto es para los usos sin JUCE (batch, CLI).
+struct ScopedFlushDenormals
+{
+   #if KORUZ_SIMD_SSE
+    ScopedFlushDenormals() : previous (_mm_getcsr()) { _mm_setcsr (previous | 0x8040u); }
+    ~ScopedFlushDenormals() { _mm_setcsr (previous); }
+    unsigned int previous;
+   #elif KORUZ_SIMD_NEON && defined(__aarch64__)
+    ScopedFlushDenormals()
+    {
+        __asm__ __volatile__ ("mrs %0, fpcr" : "=r" (previous));
+        __asm__ __volatile__ ("msr fpcr, %0" : : "r" (previous | (1ull << 24)));
+    }
+    ~ScopedFlushDenormals() { __asm__ __volatile__ ("msr fpcr, %0" : : "r" (previous)); }
+    unsigned long long previous;
+   #else
+    ScopedFlushDenormals() {}
+   #endif
+
+    ScopedFlushDenormals (const ScopedFlushDenormals&) = delete;
+    ScopedFlushDenormals& operator= (const ScopedFlushDenormals&) = delete;
+};
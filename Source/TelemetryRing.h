@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Datos de un bloque para la visualizacion
+struct ChorusTelemetry
+{
+    float peak = 0.0f;       // pico de salida, todos los canales
+    float rms = 0.0f;        // RMS de salida, todos los canales
+    float lfoPhase = 0.0f;   // ciclos, [0, 1)
+    float delayMs = 0.0f;    // delay de la primera voz al final del bloque
+};
+
+// Cola single-producer/single-consumer sin bloqueos ni memoria dinamica.
+// El hilo de audio hace push (si esta llena se descarta el bloque), el
+// editor hace pop desde su timer. Capacity debe ser potencia de dos.
+template <typename T, std::uint32_t Capacity>
+class TelemetryRing
+{
+public:
+    static_assert ((Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+    bool push (const T& item) noexcept
+    {
+        const auto w = writeIndex.load (std::memory_order_relaxed);
+        if (w - readIndex.load (std::memory_order_acquire) == Capacity)
+            return false;
+
+        items[w & (Capacity - 1)] = item;
+        writeIndex.store (w + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop (T& item) noexcept
+    {
+        const auto r = readIndex.load (std::memory_order_relaxed);
+        if (r == writeIndex.load (std::memory_order_acquire))
+            return false;
+
+        item = items[r & (Capacity - 1)];
+        readIndex.store (r + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::array<T, Capacity> items {};
+
+    // En lineas de cache distintas para que productor y consumidor no se pisen
+    alignas (64) std::atomic<std::uint32_t> writeIndex { 0 };
+    alignas (64) std::atomic<std::uint32_t> readIndex { 0 };
+};